@@ -0,0 +1,330 @@
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace.h"
+
+//
+// recording
+//
+
+// A thread's event buffer, mapped directly so that recording never
+// calls the allocator being traced. Buffers of exited threads are
+// kept for new threads.
+struct TraceBuffer {
+    TraceBuffer *next;
+    bool idle;
+    uint32_t thread;
+    uint32_t count;
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+};
+
+static std::atomic<bool> tracing(false);
+static uint64_t traceStart;
+
+// guards the file, its growth and the buffers list
+static std::mutex traceLock;
+static int traceFd = -1;
+static char *traceMap = nullptr;
+static size_t traceEnd;
+static size_t traceLength;
+static TraceBuffer *buffers = nullptr;
+static uint32_t nextThread = 0;
+
+static pthread_key_t bufferKey;
+static pthread_once_t bufferKeyOnce = PTHREAD_ONCE_INIT;
+
+static thread_local TraceBuffer *threadBuffer = nullptr;
+// set while the thread records, so that nothing recursing into the
+// allocator from here is recorded
+static thread_local bool recording = false;
+
+static uint64_t now() {
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return uint64_t(time.tv_sec) * 1000000000 + uint64_t(time.tv_nsec);
+}
+
+static bool grow_file(size_t size) {
+    if (size <= traceLength) {
+        return true;
+    }
+    size_t length = (size + TRACE_FILE_GROWTH - 1) / TRACE_FILE_GROWTH * TRACE_FILE_GROWTH;
+    if (ftruncate(traceFd, off_t(length)) != 0) {
+        return false;
+    }
+    traceLength = length;
+    return true;
+}
+
+// Appends the buffer to the file as one chunk, under traceLock.
+// Events that do not fit in TRACE_MAX_SIZE are dropped.
+static void flush_locked(TraceBuffer *buffer) {
+    size_t bytes = sizeof(TraceChunk) + buffer->count * sizeof(TraceEvent);
+    if (traceMap != nullptr && buffer->count > 0 && traceEnd + bytes <= TRACE_MAX_SIZE && grow_file(traceEnd + bytes)) {
+        TraceChunk chunk = {};
+        chunk.thread = buffer->thread;
+        chunk.count = buffer->count;
+        memcpy(traceMap + traceEnd, &chunk, sizeof(chunk));
+        memcpy(traceMap + traceEnd + sizeof(chunk), buffer->events, buffer->count * sizeof(TraceEvent));
+        traceEnd += bytes;
+    }
+    buffer->count = 0;
+}
+
+static void release_buffer(void *value) {
+    auto buffer = (TraceBuffer *)value;
+    std::lock_guard<std::mutex> guard(traceLock);
+    flush_locked(buffer);
+    buffer->idle = true;
+}
+
+static void create_buffer_key() {
+    pthread_key_create(&bufferKey, release_buffer);
+}
+
+static TraceBuffer * get_thread_buffer() {
+    if (threadBuffer != nullptr) {
+        return threadBuffer;
+    }
+
+    std::lock_guard<std::mutex> guard(traceLock);
+    TraceBuffer *buffer = buffers;
+    while (buffer != nullptr && !buffer->idle) {
+        buffer = buffer->next;
+    }
+    if (buffer == nullptr) {
+        void *memory = mmap(nullptr, sizeof(TraceBuffer), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+        buffer = (TraceBuffer *)memory;
+        buffer->next = buffers;
+        buffers = buffer;
+    }
+    buffer->idle = false;
+    buffer->thread = nextThread++;
+    buffer->count = 0;
+    pthread_setspecific(bufferKey, buffer);
+    threadBuffer = buffer;
+    return buffer;
+}
+
+uint64_t trace_clock() {
+    if (!tracing.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    return now() - traceStart;
+}
+
+static void record(TraceEventType type, void *address, void *previous, size_t size, uint64_t timestamp) {
+    if (!tracing.load(std::memory_order_relaxed) || recording) {
+        return;
+    }
+    recording = true;
+    auto buffer = get_thread_buffer();
+    if (buffer != nullptr) {
+        auto &event = buffer->events[buffer->count++];
+        event.timestamp = timestamp;
+        event.address = uint64_t(address);
+        event.previous = uint64_t(previous);
+        event.size = size;
+        event.type = type;
+        if (buffer->count == TRACE_BUFFER_EVENTS) {
+            std::lock_guard<std::mutex> guard(traceLock);
+            flush_locked(buffer);
+        }
+    }
+    recording = false;
+}
+
+bool trace_open(const char *path) {
+    pthread_once(&bufferKeyOnce, create_buffer_key);
+    std::lock_guard<std::mutex> guard(traceLock);
+    if (traceMap != nullptr) {
+        return false;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // the whole window is mapped up front; only the part inside the
+    // file is ever touched
+    void *map = mmap(nullptr, TRACE_MAX_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    traceFd = fd;
+    traceMap = (char *)map;
+    traceLength = 0;
+    if (!grow_file(sizeof(TraceHeader))) {
+        munmap(traceMap, TRACE_MAX_SIZE);
+        close(traceFd);
+        traceMap = nullptr;
+        return false;
+    }
+
+    TraceHeader header = {};
+    header.magic = TRACE_MAGIC;
+    header.eventSize = sizeof(TraceEvent);
+    memcpy(traceMap, &header, sizeof(header));
+    traceEnd = sizeof(header);
+
+    // events left over from an earlier trace
+    for (auto buffer = buffers; buffer != nullptr; buffer = buffer->next) {
+        buffer->count = 0;
+    }
+    traceStart = now();
+    tracing.store(true, std::memory_order_release);
+    return true;
+}
+
+void trace_close() {
+    tracing.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> guard(traceLock);
+    if (traceMap == nullptr) {
+        return;
+    }
+    for (auto buffer = buffers; buffer != nullptr; buffer = buffer->next) {
+        flush_locked(buffer);
+    }
+    munmap(traceMap, TRACE_MAX_SIZE);
+    // cut the growth slack off; if that fails, readers skip the zeros
+    if (ftruncate(traceFd, off_t(traceEnd)) == 0) {
+        traceLength = traceEnd;
+    }
+    close(traceFd);
+    traceMap = nullptr;
+    traceFd = -1;
+}
+
+void trace_alloc(void *address, size_t size) {
+    record(TRACE_ALLOC, address, nullptr, size, trace_clock());
+}
+
+void trace_free(void *address) {
+    record(TRACE_FREE, address, nullptr, 0, trace_clock());
+}
+
+void trace_realloc(void *previous, void *address, size_t size, uint64_t start) {
+    if (previous != nullptr && address != previous) {
+        // the old block may be reused by another thread before this
+        // returns, so its free keeps the time the realloc started
+        record(TRACE_FREE, previous, nullptr, 0, start);
+        record(TRACE_ALLOC, address, nullptr, size, trace_clock());
+        return;
+    }
+    record(TRACE_REALLOC, address, previous, size, trace_clock());
+}
+
+//
+// replay
+//
+
+// The chunks of one recorded thread, read back one at a time.
+struct TraceCursor {
+    // file offset of each chunk's events, and their count
+    std::vector<std::pair<off_t, uint32_t>> chunks;
+    size_t nextChunk = 0;
+    std::vector<TraceEvent> events;
+    size_t position = 0;
+};
+
+using TraceHead = std::pair<uint64_t, size_t>;
+
+struct TraceReader {
+    int fd;
+    std::vector<TraceCursor> cursors;
+    // next timestamp of every cursor that still has events
+    std::priority_queue<TraceHead, std::vector<TraceHead>, std::greater<TraceHead>> heads;
+};
+
+static bool load_chunk(TraceReader *reader, TraceCursor &cursor) {
+    while (cursor.nextChunk < cursor.chunks.size()) {
+        auto &chunk = cursor.chunks[cursor.nextChunk++];
+        cursor.events.resize(chunk.second);
+        cursor.position = 0;
+        size_t bytes = chunk.second * sizeof(TraceEvent);
+        if (pread(reader->fd, cursor.events.data(), bytes, chunk.first) == ssize_t(bytes)) {
+            return true;
+        }
+    }
+    cursor.events.clear();
+    return false;
+}
+
+TraceReader * trace_reader_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat status;
+    TraceHeader header;
+    if (fstat(fd, &status) != 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header)
+        || header.magic != TRACE_MAGIC || header.eventSize != sizeof(TraceEvent)) {
+        close(fd);
+        return nullptr;
+    }
+
+    auto reader = new TraceReader();
+    reader->fd = fd;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // index the chunks by thread, hopping from chunk header to chunk header
+    std::unordered_map<uint32_t, size_t> threads;
+    off_t offset = sizeof(header);
+    TraceChunk chunk;
+    while (offset + off_t(sizeof(chunk)) <= status.st_size
+           && pread(fd, &chunk, sizeof(chunk), offset) == sizeof(chunk)) {
+        offset += sizeof(chunk);
+        off_t bytes = off_t(chunk.count) * sizeof(TraceEvent);
+        if (chunk.count == 0 || offset + bytes > status.st_size) {
+            continue;
+        }
+        auto found = threads.find(chunk.thread);
+        if (found == threads.end()) {
+            found = threads.emplace(chunk.thread, reader->cursors.size()).first;
+            reader->cursors.emplace_back();
+        }
+        reader->cursors[found->second].chunks.emplace_back(offset, chunk.count);
+        offset += bytes;
+    }
+
+    for (size_t i = 0; i < reader->cursors.size(); i++) {
+        if (load_chunk(reader, reader->cursors[i])) {
+            reader->heads.emplace(reader->cursors[i].events[0].timestamp, i);
+        }
+    }
+    return reader;
+}
+
+bool trace_read(TraceReader *reader, TraceEvent *event) {
+    if (reader->heads.empty()) {
+        return false;
+    }
+    size_t index = reader->heads.top().second;
+    reader->heads.pop();
+
+    auto &cursor = reader->cursors[index];
+    *event = cursor.events[cursor.position++];
+    if (cursor.position < cursor.events.size() || load_chunk(reader, cursor)) {
+        reader->heads.emplace(cursor.events[cursor.position].timestamp, index);
+    }
+    return true;
+}
+
+void trace_reader_close(TraceReader *reader) {
+    close(reader->fd);
+    delete reader;
+}
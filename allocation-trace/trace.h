@@ -0,0 +1,95 @@
+#ifndef ALLOCATION_TRACE_TRACE_H
+#define ALLOCATION_TRACE_TRACE_H
+
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Allocation traces: a file header followed by chunks, each holding the
+// events one thread recorded since its previous flush. Events are fixed
+// size, so a trace is replayed without parsing.
+//
+
+#define TRACE_MAGIC 0x31435254434f4c41uLL  // "ALOCTRC1"
+// events a thread buffers before flushing them as one chunk
+#define TRACE_BUFFER_EVENTS 4096
+// the file grows in steps of this size, up to TRACE_MAX_SIZE
+#define TRACE_FILE_GROWTH (64uL * 1024 * 1024)
+#define TRACE_MAX_SIZE (16uL * 1024 * 1024 * 1024)
+
+enum TraceEventType {
+    TRACE_ALLOC = 1,
+    TRACE_FREE = 2,
+    // `previous` is 0 for a realloc of nullptr
+    TRACE_REALLOC = 3,
+};
+
+// An allocation is stamped after it returns and a free before it starts,
+// so across threads a block's free always sorts before its reuse. A
+// realloc that moves its block is recorded as a free stamped when it
+// started and an allocation stamped when it returned.
+struct TraceEvent {
+    // nanoseconds since trace_open
+    uint64_t timestamp;
+    uint64_t address;
+    uint64_t previous;
+    uint64_t size : 56;
+    uint64_t type : 8;
+};
+
+struct TraceHeader {
+    uint64_t magic;
+    uint32_t eventSize;
+    uint32_t reserved;
+    uint64_t padding[2];
+};
+
+struct TraceChunk {
+    uint32_t thread;
+    uint32_t count;
+    uint64_t padding[3];
+};
+
+//
+// Recording. Every thread appends to a buffer of its own, flushed into
+// the memory-mapped file when full, on thread exit and on trace_close.
+// Allocators call the trace_* hooks when built with -DALLOCATION_TRACE;
+// the hooks do nothing while no trace is open.
+//
+
+// Starts recording into `path`, truncating it. Returns false if the file
+// cannot be created or a trace is already open.
+bool trace_open(const char *path);
+
+// Flushes all buffers and closes the file. Events recorded by threads
+// still allocating while it runs may be lost.
+void trace_close();
+
+void trace_alloc(void *address, size_t size);
+
+void trace_free(void *address);
+
+// the timestamp of an event starting now, to pass to trace_realloc
+uint64_t trace_clock();
+
+// `start` is what trace_clock returned before the realloc began
+void trace_realloc(void *previous, void *address, size_t size, uint64_t start);
+
+//
+// Replay. The reader merges the threads' chunks back into one stream
+// ordered by timestamp, reading the file a chunk at a time.
+//
+
+struct TraceReader;
+
+// nullptr if the file cannot be read or is not a trace
+TraceReader * trace_reader_open(const char *path);
+
+// Returns false at the end of the trace.
+bool trace_read(TraceReader *reader, TraceEvent *event);
+
+void trace_reader_close(TraceReader *reader);
+
+
+#endif //ALLOCATION_TRACE_TRACE_H
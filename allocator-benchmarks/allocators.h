@@ -0,0 +1,26 @@
+#ifndef ALLOCATOR_BENCHMARKS_ALLOCATORS_H
+#define ALLOCATOR_BENCHMARKS_ALLOCATORS_H
+
+
+#include <cstddef>
+
+// Common face of every allocator under test. The buddy and first-fit
+// projects both declare a global `struct Block`, so each allocator is
+// wrapped in a translation unit of its own and only these function
+// tables are shared. All functions are safe to call from any thread.
+struct Allocator {
+    const char *name;
+    // called once, in the process that runs the workload
+    void (*init)();
+    void *(*allocate)(size_t size);
+    // accepts nullptr
+    void (*deallocate)(void *pointer);
+    void *(*reallocate)(void *pointer, size_t size);
+};
+
+extern const Allocator systemAllocator;
+extern const Allocator buddyAllocator;
+extern const Allocator firstFitAllocator;
+
+
+#endif //ALLOCATOR_BENCHMARKS_ALLOCATORS_H
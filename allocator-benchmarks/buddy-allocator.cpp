@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <cstring>
+#include "allocators.h"
+#include "ThreadCache.h"
+
+// One buddy arena behind SharedAllocator's mutex. The arena is malloc'ed
+// but only touched as blocks are handed out, so untouched space does
+// not count towards the resident set.
+
+#define ARENA_SIZE (1024 * 1024 * 1024)
+
+static SharedAllocator *shared = nullptr;
+
+static void init() {
+    shared = new SharedAllocator(*new MemoryAllocator(ARENA_SIZE, Measure::BYTE));
+}
+
+static void *allocate(size_t size) {
+    return shared->allocate(size);
+}
+
+static void deallocate(void *pointer) {
+    shared->deallocate(pointer);
+}
+
+// The buddy allocator has no realloc of its own: a block is kept while
+// its order still fits, otherwise moved.
+static void *reallocate(void *pointer, size_t size) {
+    if (pointer == nullptr) {
+        return allocate(size);
+    }
+    size_t blockSize = shared->getAllocator().getBlockSize(pointer);
+    if (size <= blockSize) {
+        return pointer;
+    }
+    void *moved = allocate(size);
+    if (moved != nullptr) {
+        memcpy(moved, pointer, std::min(blockSize, size));
+        deallocate(pointer);
+    }
+    return moved;
+}
+
+const Allocator buddyAllocator = {"buddy", init, allocate, deallocate, reallocate};
@@ -0,0 +1,25 @@
+#include "allocators.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// The mem_* interface: a heap per thread, large blocks mapped.
+
+static void init() {
+    init_heap();
+}
+
+static void *allocate(size_t size) {
+    return mem_alloc(size);
+}
+
+static void deallocate(void *pointer) {
+    if (pointer != nullptr) {
+        mem_free((word_t *)pointer);
+    }
+}
+
+static void *reallocate(void *pointer, size_t size) {
+    return mem_realloc((word_t *)pointer, size);
+}
+
+const Allocator firstFitAllocator = {"first-fit", init, allocate, deallocate, reallocate};
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include "histogram.h"
+
+Histogram::Histogram() : _counts(), _count(0), _max(0) {}
+
+int Histogram::getBucket(uint64_t value) {
+    if (value < (2u << HISTOGRAM_SUB_BUCKETS_SHIFT)) {
+        return int(value);
+    }
+    int shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BUCKETS_SHIFT;
+    return ((shift + 1) << HISTOGRAM_SUB_BUCKETS_SHIFT) + int(value >> shift) - (1 << HISTOGRAM_SUB_BUCKETS_SHIFT);
+}
+
+uint64_t Histogram::getBucketLimit(int bucket) {
+    if (bucket < (2 << HISTOGRAM_SUB_BUCKETS_SHIFT)) {
+        return uint64_t(bucket);
+    }
+    int shift = (bucket >> HISTOGRAM_SUB_BUCKETS_SHIFT) - 1;
+    uint64_t first = uint64_t((1 << HISTOGRAM_SUB_BUCKETS_SHIFT) + (bucket & ((1 << HISTOGRAM_SUB_BUCKETS_SHIFT) - 1))) << shift;
+    return first + (uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    _counts[getBucket(value)]++;
+    _count++;
+    _max = std::max(_max, value);
+}
+
+void Histogram::merge(const Histogram &other) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        _counts[i] += other._counts[i];
+    }
+    _count += other._count;
+    _max = std::max(_max, other._max);
+}
+
+uint64_t Histogram::getCount() const {
+    return _count;
+}
+
+uint64_t Histogram::getMax() const {
+    return _max;
+}
+
+uint64_t Histogram::getPercentile(double fraction) const {
+    if (_count == 0) {
+        return 0;
+    }
+    auto rank = uint64_t(fraction * double(_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += _counts[i];
+        if (seen >= rank) {
+            return std::min(getBucketLimit(i), _max);
+        }
+    }
+    return _max;
+}
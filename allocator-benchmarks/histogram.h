@@ -0,0 +1,37 @@
+#ifndef ALLOCATOR_BENCHMARKS_HISTOGRAM_H
+#define ALLOCATOR_BENCHMARKS_HISTOGRAM_H
+
+
+#include <cstdint>
+
+// 16 linear sub-buckets per power of two: values below 32 are exact,
+// larger ones are kept with at most 1/16 relative error.
+#define HISTOGRAM_SUB_BUCKETS_SHIFT 4
+#define HISTOGRAM_BUCKETS (64 << HISTOGRAM_SUB_BUCKETS_SHIFT)
+
+// Log-linear latency histogram in nanoseconds. Recording is a handful of
+// instructions, so every thread keeps its own and they are merged after
+// the run.
+class Histogram {
+private:
+    uint64_t _counts[HISTOGRAM_BUCKETS];
+    uint64_t _count;
+    uint64_t _max;
+
+    static int getBucket(uint64_t value);
+    static uint64_t getBucketLimit(int bucket);
+
+public:
+    Histogram();
+
+    void record(uint64_t value);
+    void merge(const Histogram &other);
+
+    uint64_t getCount() const;
+    uint64_t getMax() const;
+    // upper limit of the bucket holding the `fraction` quantile
+    uint64_t getPercentile(double fraction) const;
+};
+
+
+#endif //ALLOCATOR_BENCHMARKS_HISTOGRAM_H
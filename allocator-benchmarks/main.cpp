@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "allocators.h"
+#include "report.h"
+#include "trace.h"
+#include "workloads.h"
+
+// Runs every workload under every allocator, each pair in a forked child
+// so that it starts from a fresh heap and a fresh resident set.
+//
+//   allocator_benchmarks [--workload NAME]... [--allocator NAME]...
+//                        [--operations N] [--threads N] [--trace PATH]
+//                        [--csv PATH] [--json PATH]
+//
+// With --trace, a trace recorded by allocation-trace is replayed instead
+// of the standard workloads.
+
+#define DEFAULT_OPERATIONS 2000000
+#define DEFAULT_THREADS 4
+
+using namespace std;
+
+static const Allocator *allocators[] = {&systemAllocator, &buddyAllocator, &firstFitAllocator};
+
+// Restarts the kernel's high-water mark of the resident set (Linux 4.0+).
+static void resetPeakResidentSize() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+static long peakResidentSize() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return stol(line.substr(6)) * 1024;
+        }
+    }
+    return 0;
+}
+
+static Measurement measure(const Workload &workload, const Allocator &allocator, const WorkloadConfig &config) {
+    allocator.init();
+    auto result = new WorkloadResult();
+    resetPeakResidentSize();
+    result->baseline = residentSize();
+    workload.run(allocator, config, *result);
+
+    Measurement measurement = {};
+    strncpy(measurement.workload, workload.name, sizeof(measurement.workload) - 1);
+    strncpy(measurement.allocator, allocator.name, sizeof(measurement.allocator) - 1);
+    measurement.operations = result->operations;
+    measurement.threads = result->threads;
+    measurement.seconds = result->seconds;
+    measurement.p50 = result->latency.getPercentile(0.5);
+    measurement.p99 = result->latency.getPercentile(0.99);
+    measurement.p999 = result->latency.getPercentile(0.999);
+    measurement.max = result->latency.getMax();
+    measurement.peakRss = peakResidentSize();
+    measurement.liveBytes = result->liveBytes;
+    measurement.footprint = result->footprint;
+    measurement.exhausted = result->exhausted;
+    delete result;
+    return measurement;
+}
+
+static Measurement measureForked(const Workload &workload, const Allocator &allocator, const WorkloadConfig &config) {
+    int channel[2];
+    if (pipe(channel) != 0) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        close(channel[0]);
+        Measurement measurement = measure(workload, allocator, config);
+        ssize_t written = write(channel[1], &measurement, sizeof(measurement));
+        _exit(written == sizeof(measurement) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(channel[1]);
+
+    Measurement measurement = {};
+    if (read(channel[0], &measurement, sizeof(measurement)) != sizeof(measurement)) {
+        strncpy(measurement.workload, workload.name, sizeof(measurement.workload) - 1);
+        strncpy(measurement.allocator, allocator.name, sizeof(measurement.allocator) - 1);
+        measurement.failed = true;
+    }
+    close(channel[0]);
+    waitpid(child, nullptr, 0);
+    return measurement;
+}
+
+static bool selected(const vector<string> &names, const char *name) {
+    return names.empty() || find(names.begin(), names.end(), name) != names.end();
+}
+
+int main(int argc, char *argv[]) {
+    WorkloadConfig config = {DEFAULT_OPERATIONS, DEFAULT_THREADS, nullptr};
+    vector<string> workloadNames, allocatorNames;
+    string csvPath, jsonPath;
+
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Error: " << option << " needs a value\n";
+            return EXIT_FAILURE;
+        }
+        string value = argv[++i];
+        if (option == "--workload") {
+            workloadNames.push_back(value);
+        } else if (option == "--allocator") {
+            allocatorNames.push_back(value);
+        } else if (option == "--operations") {
+            config.operations = stol(value);
+        } else if (option == "--threads") {
+            config.threads = max(1, stoi(value));
+        } else if (option == "--trace") {
+            config.tracePath = argv[i];
+        } else if (option == "--csv") {
+            csvPath = value;
+        } else if (option == "--json") {
+            jsonPath = value;
+        } else {
+            cerr << "Error: unknown option " << option << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (config.tracePath != nullptr) {
+        TraceReader *reader = trace_reader_open(config.tracePath);
+        if (reader == nullptr) {
+            cerr << "Error: " << config.tracePath << " is not a readable trace\n";
+            return EXIT_FAILURE;
+        }
+        trace_reader_close(reader);
+    }
+
+    calibrateClock();
+    vector<Measurement> measurements;
+    for (int i = 0; i < WORKLOADS_COUNT; i++) {
+        bool wanted = workloadNames.empty() ? workloads[i].replaysTrace == (config.tracePath != nullptr)
+                                            : selected(workloadNames, workloads[i].name);
+        if (!wanted || (workloads[i].replaysTrace && config.tracePath == nullptr)) {
+            continue;
+        }
+        for (auto allocator : allocators) {
+            if (selected(allocatorNames, allocator->name)) {
+                measurements.push_back(measureForked(workloads[i], *allocator, config));
+            }
+        }
+    }
+
+    printTable(measurements);
+    if (!csvPath.empty() && !writeCsv(csvPath, measurements)) {
+        cerr << "Error: cannot write " << csvPath << "\n";
+        return EXIT_FAILURE;
+    }
+    if (!jsonPath.empty() && !writeJson(jsonPath, measurements)) {
+        cerr << "Error: cannot write " << jsonPath << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
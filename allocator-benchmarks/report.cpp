@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "report.h"
+
+using namespace std;
+
+double getOpsPerSecond(const Measurement &measurement) {
+    return measurement.seconds > 0 ? measurement.operations / measurement.seconds : 0;
+}
+
+double getFragmentation(const Measurement &measurement) {
+    if (measurement.liveBytes == 0 || measurement.footprint <= 0) {
+        return -1;
+    }
+    return max(0.0, 1.0 - double(measurement.liveBytes) / double(measurement.footprint));
+}
+
+static const char *getStatus(const Measurement &measurement) {
+    if (measurement.failed) {
+        return "failed";
+    }
+    return measurement.exhausted ? "exhausted" : "ok";
+}
+
+void printTable(const vector<Measurement> &measurements) {
+    cout << left << setw(20) << "workload" << setw(12) << "allocator" << right
+         << setw(8) << "threads" << setw(10) << "Mops/s" << setw(10) << "p50 ns" << setw(10) << "p99 ns"
+         << setw(10) << "p99.9 ns" << setw(12) << "max ns" << setw(14) << "peak RSS KB"
+         << setw(10) << "frag" << "  status" << endl;
+    for (auto &measurement : measurements) {
+        cout << left << setw(20) << measurement.workload << setw(12) << measurement.allocator << right
+             << setw(8) << measurement.threads
+             << setw(10) << fixed << setprecision(2) << getOpsPerSecond(measurement) / 1e6
+             << setw(10) << measurement.p50 << setw(10) << measurement.p99
+             << setw(10) << measurement.p999 << setw(12) << measurement.max
+             << setw(14) << measurement.peakRss / 1024;
+        double fragmentation = getFragmentation(measurement);
+        if (fragmentation < 0) {
+            cout << setw(10) << "-";
+        } else {
+            cout << setw(10) << setprecision(3) << fragmentation;
+        }
+        cout << "  " << getStatus(measurement) << endl;
+    }
+}
+
+bool writeCsv(const string &path, const vector<Measurement> &measurements) {
+    ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "workload,allocator,threads,operations,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns,max_ns,"
+           "peak_rss_bytes,live_bytes,footprint_bytes,fragmentation,status\n";
+    for (auto &measurement : measurements) {
+        double fragmentation = getFragmentation(measurement);
+        out << measurement.workload << ',' << measurement.allocator << ',' << measurement.threads << ','
+            << measurement.operations << ',' << setprecision(6) << measurement.seconds << ','
+            << fixed << setprecision(0) << getOpsPerSecond(measurement) << defaultfloat << ','
+            << measurement.p50 << ',' << measurement.p99 << ',' << measurement.p999 << ',' << measurement.max << ','
+            << measurement.peakRss << ',' << measurement.liveBytes << ',' << measurement.footprint << ',';
+        if (fragmentation >= 0) {
+            out << setprecision(4) << fragmentation;
+        }
+        out << ',' << getStatus(measurement) << '\n';
+    }
+    return bool(out);
+}
+
+bool writeJson(const string &path, const vector<Measurement> &measurements) {
+    ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "[\n";
+    for (size_t i = 0; i < measurements.size(); i++) {
+        auto &measurement = measurements[i];
+        double fragmentation = getFragmentation(measurement);
+        out << "  {\"workload\": \"" << measurement.workload << "\", \"allocator\": \"" << measurement.allocator
+            << "\", \"threads\": " << measurement.threads << ", \"operations\": " << measurement.operations
+            << ", \"seconds\": " << setprecision(6) << measurement.seconds
+            << ", \"ops_per_sec\": " << fixed << setprecision(0) << getOpsPerSecond(measurement) << defaultfloat
+            << ", \"latency_ns\": {\"p50\": " << measurement.p50 << ", \"p99\": " << measurement.p99
+            << ", \"p999\": " << measurement.p999 << ", \"max\": " << measurement.max << "}"
+            << ", \"peak_rss_bytes\": " << measurement.peakRss << ", \"live_bytes\": " << measurement.liveBytes
+            << ", \"footprint_bytes\": " << measurement.footprint << ", \"fragmentation\": ";
+        if (fragmentation >= 0) {
+            out << setprecision(4) << fragmentation;
+        } else {
+            out << "null";
+        }
+        out << ", \"status\": \"" << getStatus(measurement) << "\"}" << (i + 1 < measurements.size() ? "," : "") << '\n';
+    }
+    out << "]\n";
+    return bool(out);
+}
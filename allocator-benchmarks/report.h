@@ -0,0 +1,43 @@
+#ifndef ALLOCATOR_BENCHMARKS_REPORT_H
+#define ALLOCATOR_BENCHMARKS_REPORT_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One workload run under one allocator, as sent back by the child
+// process that ran it.
+struct Measurement {
+    char workload[32];
+    char allocator[16];
+    long operations;
+    int threads;
+    double seconds;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+    // high-water resident size of the run, in bytes
+    long peakRss;
+    size_t liveBytes;
+    long footprint;
+    bool exhausted;
+    // the child died before reporting
+    bool failed;
+};
+
+double getOpsPerSecond(const Measurement &measurement);
+
+// 1 - live bytes / resident bytes gained at the measuring point,
+// negative where the workload holds nothing
+double getFragmentation(const Measurement &measurement);
+
+void printTable(const std::vector<Measurement> &measurements);
+
+// Returns false if the file cannot be written.
+bool writeCsv(const std::string &path, const std::vector<Measurement> &measurements);
+bool writeJson(const std::string &path, const std::vector<Measurement> &measurements);
+
+
+#endif //ALLOCATOR_BENCHMARKS_REPORT_H
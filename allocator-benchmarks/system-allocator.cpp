@@ -0,0 +1,8 @@
+#include <cstdlib>
+#include "allocators.h"
+
+// glibc malloc, the baseline.
+
+static void init() {}
+
+const Allocator systemAllocator = {"glibc", init, malloc, free, realloc};
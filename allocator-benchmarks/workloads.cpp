@@ -0,0 +1,473 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "trace.h"
+#include "workloads.h"
+
+// Standard allocator workloads. Every allocator call is timed on its own;
+// payloads are written in full outside the timed region, so the resident
+// set reflects what the program really uses.
+
+// blocks held by the single-threaded churn workloads
+#define CHURN_SLOTS 10000
+#define RING_SIZE 4096
+// blocks held by each Larson thread, which hands them to its successor
+// at the end of every epoch
+#define LARSON_SLOTS 1000
+#define LARSON_EPOCHS 10
+// buffers grown side by side, each up to REALLOC_LIMIT before it is
+// freed and started again
+#define REALLOC_BUFFERS 64
+#define REALLOC_LIMIT (1024 * 1024)
+
+using namespace std;
+using namespace std::chrono;
+
+static uint64_t clockOverhead = 0;
+
+static uint64_t now() {
+    return uint64_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void calibrateClock() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 10000; i++) {
+        uint64_t start = now();
+        best = min(best, now() - start);
+    }
+    clockOverhead = best;
+}
+
+long residentSize() {
+    long pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void record(Histogram &latency, uint64_t start) {
+    uint64_t elapsed = now() - start;
+    latency.record(elapsed > clockOverhead ? elapsed - clockOverhead : 0);
+}
+
+static void *timedAllocate(const Allocator &allocator, size_t size, Histogram &latency) {
+    uint64_t start = now();
+    void *pointer = allocator.allocate(size);
+    record(latency, start);
+    return pointer;
+}
+
+static void timedDeallocate(const Allocator &allocator, void *pointer, Histogram &latency) {
+    uint64_t start = now();
+    allocator.deallocate(pointer);
+    record(latency, start);
+}
+
+static void *timedReallocate(const Allocator &allocator, void *pointer, size_t size, Histogram &latency) {
+    uint64_t start = now();
+    void *moved = allocator.reallocate(pointer, size);
+    record(latency, start);
+    return moved;
+}
+
+static double secondsSince(steady_clock::time_point start) {
+    return duration<double>(steady_clock::now() - start).count();
+}
+
+static void measureFootprint(WorkloadResult &result, size_t liveBytes) {
+    result.liveBytes = liveBytes;
+    result.footprint = residentSize() - result.baseline;
+}
+
+// Replaces random slots of a fixed working set, one free and one
+// allocation at a time.
+template <typename Sizes>
+static void churn(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result, Sizes sizes) {
+    mt19937 random(42);
+    uniform_int_distribution<int> pick(0, CHURN_SLOTS - 1);
+    vector<void *> slots(CHURN_SLOTS, nullptr);
+    vector<size_t> slotSizes(CHURN_SLOTS, 0);
+
+    long operations = 0;
+    auto start = steady_clock::now();
+    while (operations < config.operations) {
+        int position = pick(random);
+        if (slots[position] != nullptr) {
+            timedDeallocate(allocator, slots[position], result.latency);
+            slots[position] = nullptr;
+            slotSizes[position] = 0;
+            operations++;
+        }
+        size_t size = sizes(random);
+        void *pointer = timedAllocate(allocator, size, result.latency);
+        operations++;
+        if (pointer == nullptr) {
+            result.exhausted = true;
+            break;
+        }
+        memset(pointer, 1, size);
+        slots[position] = pointer;
+        slotSizes[position] = size;
+    }
+    result.seconds = secondsSince(start);
+    result.operations = operations;
+    result.threads = 1;
+
+    measureFootprint(result, accumulate(slotSizes.begin(), slotSizes.end(), size_t(0)));
+    for (auto pointer : slots) {
+        allocator.deallocate(pointer);
+    }
+}
+
+static void fixedChurn(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result) {
+    churn(allocator, config, result, [](mt19937 &) { return size_t(64); });
+}
+
+// sizes spread evenly over the powers of two from 8 bytes to 8 KB,
+// so most requests are small
+static void randomChurn(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result) {
+    uniform_int_distribution<int> exponents(3, 12);
+    churn(allocator, config, result, [&exponents](mt19937 &random) {
+        size_t low = size_t(1) << exponents(random);
+        return uniform_int_distribution<size_t>(low, 2 * low)(random);
+    });
+}
+
+// single-producer single-consumer ring of block pointers
+struct Ring {
+    void *slots[RING_SIZE];
+    atomic<size_t> head{0};
+    atomic<size_t> tail{0};
+
+    void push(void *pointer) {
+        size_t position = tail.load(memory_order_relaxed);
+        while (position - head.load(memory_order_acquire) == RING_SIZE) {
+            this_thread::yield();
+        }
+        slots[position % RING_SIZE] = pointer;
+        tail.store(position + 1, memory_order_release);
+    }
+
+    void *pop() {
+        size_t position = head.load(memory_order_relaxed);
+        while (tail.load(memory_order_acquire) == position) {
+            this_thread::yield();
+        }
+        void *pointer = slots[position % RING_SIZE];
+        head.store(position + 1, memory_order_release);
+        return pointer;
+    }
+};
+
+// One thread allocates, another frees: every free is a cross-thread one.
+// A null pointer in the ring ends the run early.
+static void producerConsumer(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result) {
+    long items = config.operations / 2;
+    auto ring = new Ring();
+    Histogram producerLatency;
+    atomic<bool> exhausted(false);
+
+    auto start = steady_clock::now();
+    thread producer([&allocator, &producerLatency, &exhausted, ring, items]() {
+        mt19937 random(42);
+        uniform_int_distribution<size_t> sizes(64, 1024);
+        for (long i = 0; i < items; i++) {
+            size_t size = sizes(random);
+            void *pointer = timedAllocate(allocator, size, producerLatency);
+            if (pointer == nullptr) {
+                exhausted = true;
+                ring->push(nullptr);
+                return;
+            }
+            memset(pointer, 1, size);
+            ring->push(pointer);
+        }
+    });
+    thread consumer([&allocator, &result, ring, items]() {
+        for (long i = 0; i < items; i++) {
+            void *pointer = ring->pop();
+            if (pointer == nullptr) {
+                return;
+            }
+            timedDeallocate(allocator, pointer, result.latency);
+        }
+    });
+    producer.join();
+    consumer.join();
+    result.seconds = secondsSince(start);
+    delete ring;
+
+    result.latency.merge(producerLatency);
+    result.operations = long(result.latency.getCount());
+    result.threads = 2;
+    result.exhausted = exhausted;
+    measureFootprint(result, 0);
+}
+
+struct LarsonSlots {
+    void *pointers[LARSON_SLOTS];
+    size_t sizes[LARSON_SLOTS];
+};
+
+// Larson-style server: each thread replaces random blocks of its set and
+// exits; a new thread takes the set over in the next epoch, so blocks are
+// freed by threads that did not allocate them.
+static void larson(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result) {
+    int threadsCount = config.threads;
+    long rounds = config.operations / 2 / threadsCount / LARSON_EPOCHS;
+    vector<LarsonSlots> sets(threadsCount);
+    vector<Histogram> latencies(threadsCount);
+    for (auto &set : sets) {
+        fill(begin(set.pointers), end(set.pointers), nullptr);
+        fill(begin(set.sizes), end(set.sizes), 0);
+    }
+    atomic<bool> exhausted(false);
+
+    auto start = steady_clock::now();
+    for (int epoch = 0; epoch < LARSON_EPOCHS && !exhausted; epoch++) {
+        vector<thread> threads;
+        for (int i = 0; i < threadsCount; i++) {
+            auto &set = sets[(i + epoch) % threadsCount];
+            auto &latency = latencies[i];
+            threads.emplace_back([&allocator, &set, &latency, &exhausted, rounds, epoch, i]() {
+                mt19937 random(unsigned(epoch * 1000 + i));
+                uniform_int_distribution<int> pick(0, LARSON_SLOTS - 1);
+                uniform_int_distribution<size_t> sizes(16, 1024);
+                for (long round = 0; round < rounds; round++) {
+                    int position = pick(random);
+                    if (set.pointers[position] != nullptr) {
+                        timedDeallocate(allocator, set.pointers[position], latency);
+                    }
+                    size_t size = sizes(random);
+                    void *pointer = timedAllocate(allocator, size, latency);
+                    set.pointers[position] = pointer;
+                    set.sizes[position] = pointer == nullptr ? 0 : size;
+                    if (pointer == nullptr) {
+                        exhausted = true;
+                        return;
+                    }
+                    memset(pointer, 1, size);
+                }
+            });
+        }
+        for (auto &worker : threads) {
+            worker.join();
+        }
+    }
+    result.seconds = secondsSince(start);
+
+    for (auto &latency : latencies) {
+        result.latency.merge(latency);
+    }
+    result.operations = long(result.latency.getCount());
+    result.threads = threadsCount;
+    result.exhausted = exhausted;
+
+    size_t liveBytes = 0;
+    for (auto &set : sets) {
+        liveBytes = accumulate(begin(set.sizes), end(set.sizes), liveBytes);
+    }
+    measureFootprint(result, liveBytes);
+    for (auto &set : sets) {
+        for (auto pointer : set.pointers) {
+            allocator.deallocate(pointer);
+        }
+    }
+}
+
+// Buffers appended to in random steps, interleaved so that a buffer's
+// neighbour is usually another growing buffer.
+static void reallocGrowth(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result) {
+    mt19937 random(42);
+    uniform_int_distribution<size_t> steps(16, 4096);
+    vector<void *> buffers(REALLOC_BUFFERS, nullptr);
+    vector<size_t> sizes(REALLOC_BUFFERS, 0);
+
+    long operations = 0;
+    auto start = steady_clock::now();
+    while (operations < config.operations && !result.exhausted) {
+        for (int i = 0; i < REALLOC_BUFFERS && operations < config.operations; i++) {
+            if (sizes[i] >= REALLOC_LIMIT) {
+                timedDeallocate(allocator, buffers[i], result.latency);
+                buffers[i] = nullptr;
+                sizes[i] = 0;
+                operations++;
+            }
+            size_t size = sizes[i] + steps(random);
+            void *moved = timedReallocate(allocator, buffers[i], size, result.latency);
+            operations++;
+            if (moved == nullptr) {
+                result.exhausted = true;
+                break;
+            }
+            memset((char *)moved + sizes[i], 1, size - sizes[i]);
+            buffers[i] = moved;
+            sizes[i] = size;
+        }
+    }
+    result.seconds = secondsSince(start);
+    result.operations = operations;
+    result.threads = 1;
+
+    measureFootprint(result, accumulate(sizes.begin(), sizes.end(), size_t(0)));
+    for (auto pointer : buffers) {
+        allocator.deallocate(pointer);
+    }
+}
+
+// Recorded addresses mapped to replayed blocks: open addressing with
+// linear probing, in a single allocation that is rebuilt as it fills.
+class AddressMap {
+private:
+    struct Entry {
+        uint64_t address;
+        void *pointer;
+        size_t size;
+    };
+    // marks a slot whose entry was removed
+    static constexpr uint64_t REMOVED = ~uint64_t(0);
+
+    vector<Entry> _entries;
+    size_t _used = 0;
+    size_t _count = 0;
+    size_t _liveBytes = 0;
+
+    size_t getSlot(uint64_t address) const {
+        // block addresses are 8-aligned, so multiply the low bits away
+        return size_t((address * 0x9e3779b97f4a7c15uLL) >> 20) & (_entries.size() - 1);
+    }
+
+    void rebuild(size_t capacity) {
+        vector<Entry> entries(capacity, Entry{0, nullptr, 0});
+        swap(entries, _entries);
+        _used = _count;
+        for (auto &entry : entries) {
+            if (entry.address != 0 && entry.address != REMOVED) {
+                size_t slot = getSlot(entry.address);
+                while (_entries[slot].address != 0) {
+                    slot = (slot + 1) & (_entries.size() - 1);
+                }
+                _entries[slot] = entry;
+            }
+        }
+    }
+
+public:
+    AddressMap() : _entries(1024, Entry{0, nullptr, 0}) {}
+
+    size_t getLiveBytes() const {
+        return _liveBytes;
+    }
+
+    void insert(uint64_t address, void *pointer, size_t size) {
+        if (2 * (_used + 1) > _entries.size()) {
+            // grow once live entries fill a quarter, otherwise only drop
+            // the removed ones
+            rebuild(4 * (_count + 1) > _entries.size() ? 2 * _entries.size() : _entries.size());
+        }
+        size_t slot = getSlot(address);
+        while (_entries[slot].address != 0 && _entries[slot].address != REMOVED) {
+            slot = (slot + 1) & (_entries.size() - 1);
+        }
+        if (_entries[slot].address == 0) {
+            _used++;
+        }
+        _entries[slot] = Entry{address, pointer, size};
+        _count++;
+        _liveBytes += size;
+    }
+
+    // Takes the entry of `address` out, returning its pointer or nullptr.
+    void *remove(uint64_t address) {
+        for (size_t slot = getSlot(address); _entries[slot].address != 0; slot = (slot + 1) & (_entries.size() - 1)) {
+            if (_entries[slot].address == address) {
+                _entries[slot].address = REMOVED;
+                _count--;
+                _liveBytes -= _entries[slot].size;
+                return _entries[slot].pointer;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visitor) {
+        for (auto &entry : _entries) {
+            if (entry.address != 0 && entry.address != REMOVED) {
+                visitor(entry.pointer);
+            }
+        }
+    }
+};
+
+// Streams a recorded trace through the allocator on one thread, in
+// timestamp order. Blocks allocated before recording started are
+// unknown to the trace, so their frees are skipped.
+static void replay(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result) {
+    TraceReader *reader = trace_reader_open(config.tracePath);
+    if (reader == nullptr) {
+        return;
+    }
+    AddressMap blocks;
+    TraceEvent event;
+
+    long operations = 0;
+    auto start = steady_clock::now();
+    while (trace_read(reader, &event)) {
+        if (event.type == TRACE_ALLOC) {
+            void *pointer = timedAllocate(allocator, event.size, result.latency);
+            if (pointer == nullptr) {
+                result.exhausted = true;
+                break;
+            }
+            memset(pointer, 1, event.size);
+            blocks.insert(event.address, pointer, event.size);
+        } else if (event.type == TRACE_FREE) {
+            void *pointer = blocks.remove(event.address);
+            if (pointer == nullptr) {
+                continue;
+            }
+            timedDeallocate(allocator, pointer, result.latency);
+        } else if (event.type == TRACE_REALLOC) {
+            void *pointer = event.previous == 0 ? nullptr : blocks.remove(event.previous);
+            if (pointer == nullptr && event.previous != 0) {
+                // grown from a block the trace never saw
+                pointer = timedAllocate(allocator, event.size, result.latency);
+            } else {
+                pointer = timedReallocate(allocator, pointer, event.size, result.latency);
+            }
+            if (pointer == nullptr) {
+                result.exhausted = true;
+                break;
+            }
+            blocks.insert(event.address, pointer, event.size);
+        }
+        operations++;
+    }
+    result.seconds = secondsSince(start);
+    result.operations = operations;
+    result.threads = 1;
+    trace_reader_close(reader);
+
+    measureFootprint(result, blocks.getLiveBytes());
+    blocks.forEach([&allocator](void *pointer) {
+        allocator.deallocate(pointer);
+    });
+}
+
+const Workload workloads[] = {
+        {"fixed-churn", fixedChurn, false},
+        {"random-churn", randomChurn, false},
+        {"producer-consumer", producerConsumer, false},
+        {"larson", larson, false},
+        {"realloc-growth", reallocGrowth, false},
+        {"replay", replay, true},
+};
+
+const int WORKLOADS_COUNT = sizeof(workloads) / sizeof(workloads[0]);
@@ -0,0 +1,50 @@
+#ifndef ALLOCATOR_BENCHMARKS_WORKLOADS_H
+#define ALLOCATOR_BENCHMARKS_WORKLOADS_H
+
+
+#include <cstddef>
+#include "allocators.h"
+#include "histogram.h"
+
+struct WorkloadConfig {
+    // allocator calls made by the whole run, roughly
+    long operations;
+    // worker threads of the multi-threaded workloads
+    int threads;
+    // recorded trace to replay, nullptr if none
+    const char *tracePath;
+};
+
+struct WorkloadResult {
+    long operations;
+    int threads;
+    double seconds;
+    // every timed allocator call, clock overhead subtracted
+    Histogram latency;
+    // resident size when the workload started
+    long baseline;
+    // bytes the program asked for and still holds at the measuring point,
+    // and the resident bytes gained by then; 0 where nothing is held
+    size_t liveBytes;
+    long footprint;
+    // the allocator ran out of memory and the run was cut short
+    bool exhausted;
+};
+
+struct Workload {
+    const char *name;
+    void (*run)(const Allocator &allocator, const WorkloadConfig &config, WorkloadResult &result);
+    // runs only when a trace is given
+    bool replaysTrace;
+};
+
+extern const Workload workloads[];
+extern const int WORKLOADS_COUNT;
+
+long residentSize();
+
+// Measures the cost of reading the clock, subtracted from every sample.
+void calibrateClock();
+
+
+#endif //ALLOCATOR_BENCHMARKS_WORKLOADS_H
@@ -0,0 +1,91 @@
+#ifndef BUDDY_ALLOCATION_ALLOCATORSTATS_H
+#define BUDDY_ALLOCATION_ALLOCATORSTATS_H
+
+
+#include <atomic>
+
+// one slot per possible block order
+#define STATS_ORDERS 64
+
+// Snapshot of an allocator's counters, all in bytes or events.
+struct AllocatorStats {
+    unsigned long allocations[STATS_ORDERS];
+    unsigned long frees[STATS_ORDERS];
+    unsigned long failedAllocations;
+    // sizes of allocated blocks, i.e. requests rounded up to their order
+    unsigned long bytesInUse;
+    unsigned long peakBytesInUse;
+    unsigned long bytesReserved;
+    // blocks halved on allocation and buddies merged on free
+    unsigned long splits;
+    unsigned long merges;
+    // mappings, unmappings and madvise calls
+    unsigned long osRequests;
+    unsigned long largestFreeBlock;
+
+    // sums another allocator's stats into these
+    void add(const AllocatorStats &other) {
+        for (int i = 0; i < STATS_ORDERS; i++) {
+            allocations[i] += other.allocations[i];
+            frees[i] += other.frees[i];
+        }
+        failedAllocations += other.failedAllocations;
+        bytesInUse += other.bytesInUse;
+        peakBytesInUse += other.peakBytesInUse;
+        bytesReserved += other.bytesReserved;
+        splits += other.splits;
+        merges += other.merges;
+        osRequests += other.osRequests;
+        largestFreeBlock = largestFreeBlock > other.largestFreeBlock ? largestFreeBlock : other.largestFreeBlock;
+    }
+};
+
+// Event counter with a single writer at a time (the allocator's user,
+// or whoever holds its lock) that any thread may read. A relaxed load
+// and store cost the same as a plain increment. Built with
+// -DNO_ALLOCATOR_STATS, counters compile to nothing and read as 0.
+class StatCounter {
+private:
+#ifndef NO_ALLOCATOR_STATS
+    std::atomic<unsigned long> _value{0};
+#endif
+
+public:
+    void add(unsigned long value = 1) {
+#ifndef NO_ALLOCATOR_STATS
+        _value.store(_value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+#else
+        (void)value;
+#endif
+    }
+
+    void subtract(unsigned long value) {
+#ifndef NO_ALLOCATOR_STATS
+        _value.store(_value.load(std::memory_order_relaxed) - value, std::memory_order_relaxed);
+#else
+        (void)value;
+#endif
+    }
+
+    // keeps the largest value seen
+    void raise(unsigned long value) {
+#ifndef NO_ALLOCATOR_STATS
+        if (value > _value.load(std::memory_order_relaxed)) {
+            _value.store(value, std::memory_order_relaxed);
+        }
+#else
+        (void)value;
+#endif
+    }
+
+    unsigned long get() const {
+#ifndef NO_ALLOCATOR_STATS
+        return _value.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+};
+
+
+#endif //BUDDY_ALLOCATION_ALLOCATORSTATS_H
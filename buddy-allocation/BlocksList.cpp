@@ -28,91 +28,48 @@ int BlocksList::getLength() {
 }
 
 void BlocksList::print() {
-    auto *iterator = new ListBlock;
-    iterator = _head;
+    ListBlock *iterator = _head;
 
     while (iterator != nullptr) {
-        std::cout << iterator->address << " ";
+        std::cout << (void *)iterator << " ";
         iterator = iterator->next;
     }
 }
 
-ListBlock *BlocksList::get(unsigned int position) {
-    auto *current = new ListBlock;
-    current = _head;
-    if (position > 0) {
-        for (int i = 0; i < position; i++) {
-            current = current->next;
-        }
-    }
-    return current;
-}
-
 void BlocksList::unshift(void *address) {
-    auto *newBlock = new ListBlock;
-    newBlock->address = address;
-    newBlock->next = nullptr;
+    auto *newBlock = (ListBlock *)address;
+    newBlock->prev = nullptr;
+    newBlock->next = _head;
     if (_length == 0) {
-        _head = newBlock;
         _tail = newBlock;
     } else {
-        newBlock->next = _head;
-        _head = newBlock;
+        _head->prev = newBlock;
     }
+    _head = newBlock;
     _length++;
 }
 
-void BlocksList::push(void *address) {
-    auto *newBlock = new ListBlock;
-    newBlock->address = address;
-    newBlock->next = nullptr;
+void *BlocksList::shift() {
     if (_length == 0) {
-        _head = newBlock;
-        _tail = newBlock;
-    }
-    else {
-        ListBlock *secondLastBlock = get((_length == 1) ? 0 : _length - 2);
-        secondLastBlock->next = newBlock;
-        _tail = newBlock;
+        return nullptr;
     }
-    _length++;
+    void *address = _head;
+    remove(address);
+    return address;
 }
 
-void BlocksList::insert(unsigned int position, void *address) {
-    if (_length == 0 || position == 0) {
-        unshift(address);
+void BlocksList::remove(void *address) {
+    // the node lives in the block, so unlinking by address is O(1)
+    auto *block = (ListBlock *)address;
+    if (block->prev != nullptr) {
+        block->prev->next = block->next;
+    } else {
+        _head = block->next;
     }
-    else {
-        auto *newBlock = new ListBlock;
-        newBlock->address = address;
-        auto *beforeBlock = new ListBlock;
-        beforeBlock = get(position - 1);
-        newBlock->next = beforeBlock->next;
-        beforeBlock->next = newBlock;
-        _length++;
+    if (block->next != nullptr) {
+        block->next->prev = block->prev;
+    } else {
+        _tail = block->prev;
     }
+    _length--;
 }
-
-void BlocksList::remove(unsigned int position) {
-    if (_length != 0 && position < _length) {
-        auto *blockForRemove = new ListBlock;
-        blockForRemove = get(position);
-        if (_length == 1) {
-            _head = nullptr;
-            _tail = nullptr;
-        } else {
-            if (position == 0) {
-                _head = blockForRemove->next;
-            } else {
-                auto *blockBefore = new ListBlock;
-                blockBefore = get(position - 1);
-                blockBefore->next = blockForRemove->next;
-                if (position == _length - 1) {
-                    _tail = blockBefore;
-                }
-            }
-        }
-        delete blockForRemove;
-        _length--;
-    }
-}
\ No newline at end of file
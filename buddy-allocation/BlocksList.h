@@ -3,8 +3,10 @@
 
 #define DEFAULT_BLOCK_SIZE 64
 
+// List node stored in the first bytes of a free block,
+// so the node address is the block address itself.
 struct ListBlock {
-    void *address;
+    ListBlock *prev;
     ListBlock *next;
 };
 
@@ -24,11 +26,9 @@ class BlocksList {
         int getBlockSize();
         int getLength();
         void print();
-        ListBlock *get(unsigned int position);
         void unshift(void *address);
-        void push(void *address);
-        void insert(unsigned int position, void *address);
-        void remove(unsigned int position);
+        void *shift();
+        void remove(void *address);
 };
 
 
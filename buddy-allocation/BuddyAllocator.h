@@ -0,0 +1,185 @@
+#ifndef BUDDY_ALLOCATION_BUDDYALLOCATOR_H
+#define BUDDY_ALLOCATION_BUDDYALLOCATOR_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include "BlocksList.h"
+
+// Buddy allocator with its geometry fixed at compile time: blocks range
+// from 2^MinOrder to 2^MaxOrder bytes and the arena is one top-level block.
+// Sizes, bitmap offsets and loop bounds are constants, so the compiler folds
+// the size-class math; use MemoryAllocator when the size is only known at startup.
+template <unsigned int MinOrder, unsigned int MaxOrder>
+class BuddyAllocator {
+    static_assert(MinOrder >= 4, "a free block must hold its list node");
+    static_assert(MaxOrder >= MinOrder && MaxOrder < 48, "invalid order range");
+
+public:
+    static constexpr int OrdersCount = MaxOrder - MinOrder + 1;
+    static constexpr size_t UnitsCount = size_t(1) << (MaxOrder - MinOrder);
+
+    static constexpr size_t getSize() {
+        return size_t(1) << MaxOrder;
+    }
+
+    static constexpr size_t getOrderSize(int order) {
+        return size_t(1) << (MinOrder + order);
+    }
+
+    static constexpr int getOrder(size_t size) {
+        return size <= getOrderSize(0) ? 0 : 64 - __builtin_clzll(size - 1) - int(MinOrder);
+    }
+
+private:
+    // Block size and free bitmap offset (in bits) of every order,
+    // built by the compiler and indexed instead of recomputed.
+    struct OrderTable {
+        size_t sizes[OrdersCount];
+        size_t mapOffsets[OrdersCount + 1];
+
+        constexpr OrderTable() : sizes(), mapOffsets() {
+            for (int i = 0; i < OrdersCount; i++) {
+                sizes[i] = getOrderSize(i);
+                mapOffsets[i + 1] = mapOffsets[i] + ((UnitsCount >> i) + 63) / 64 * 64;
+            }
+        }
+    };
+    static constexpr OrderTable Table = OrderTable();
+
+    char *_memory;
+    ListBlock *_heads[OrdersCount];
+    uint64_t *_freeMaps;
+    unsigned char *_orders;
+    uint64_t _nonEmptyOrders;
+
+    char *getUnitAddress(size_t index) {
+        return _memory + (index << MinOrder);
+    }
+
+    size_t getUnitIndex(void *address) {
+        return size_t((char *)address - _memory) >> MinOrder;
+    }
+
+    bool isFree(int order, size_t index) {
+        size_t bit = Table.mapOffsets[order] + (index >> order);
+        return (_freeMaps[bit / 64] >> (bit % 64)) & 1u;
+    }
+
+    void pushFree(int order, size_t index) {
+        size_t bit = Table.mapOffsets[order] + (index >> order);
+        _freeMaps[bit / 64] |= uint64_t(1) << (bit % 64);
+
+        auto *block = (ListBlock *)getUnitAddress(index);
+        block->prev = nullptr;
+        block->next = _heads[order];
+        if (block->next != nullptr) {
+            block->next->prev = block;
+        }
+        _heads[order] = block;
+        _nonEmptyOrders |= uint64_t(1) << order;
+    }
+
+    void removeFree(int order, size_t index) {
+        size_t bit = Table.mapOffsets[order] + (index >> order);
+        _freeMaps[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+
+        auto *block = (ListBlock *)getUnitAddress(index);
+        if (block->prev != nullptr) {
+            block->prev->next = block->next;
+        } else {
+            _heads[order] = block->next;
+        }
+        if (block->next != nullptr) {
+            block->next->prev = block->prev;
+        }
+        if (_heads[order] == nullptr) {
+            _nonEmptyOrders &= ~(uint64_t(1) << order);
+        }
+    }
+
+public:
+    BuddyAllocator() {
+        _memory = (char *)malloc(getSize());
+        if (_memory == nullptr) {
+            std::cerr << "Error: Out of memory\n";
+            exit(EXIT_SUCCESS);
+        }
+        _freeMaps = new uint64_t[Table.mapOffsets[OrdersCount] / 64]();
+        _orders = new unsigned char[UnitsCount]();
+
+        for (auto &head : _heads) {
+            head = nullptr;
+        }
+        _nonEmptyOrders = 0;
+        pushFree(OrdersCount - 1, 0);
+    }
+
+    BuddyAllocator(const BuddyAllocator &) = delete;
+    BuddyAllocator &operator=(const BuddyAllocator &) = delete;
+
+    ~BuddyAllocator() {
+        delete[] _orders;
+        delete[] _freeMaps;
+        std::free(_memory);
+    }
+
+    char *getMemoryPointer() {
+        return _memory;
+    }
+
+    void *allocate(size_t size) {
+        int targetOrder = getOrder(size);
+        if (targetOrder >= OrdersCount) {
+            return nullptr;
+        }
+
+        uint64_t usable = _nonEmptyOrders & (~uint64_t(0) << targetOrder);
+        if (usable == 0) {
+            return nullptr;
+        }
+        int order = __builtin_ctzll(usable);
+
+        size_t index = getUnitIndex(_heads[order]);
+        removeFree(order, index);
+        while (order > targetOrder) {
+            order--;
+            pushFree(order, index + (size_t(1) << order));
+        }
+
+        _orders[index] = (unsigned char)targetOrder;
+        return getUnitAddress(index);
+    }
+
+    void deallocate(void *pointer) {
+        if (pointer == nullptr) {
+            return;
+        }
+        size_t index = getUnitIndex(pointer);
+        int order = _orders[index];
+
+        // the arena is a single top-level block, so every buddy is in range
+        while (order < OrdersCount - 1) {
+            size_t buddy = index ^ (size_t(1) << order);
+            if (!isFree(order, buddy)) {
+                break;
+            }
+            removeFree(order, buddy);
+            index &= ~(size_t(1) << order);
+            order++;
+        }
+        pushFree(order, index);
+    }
+
+    size_t getBlockSize(void *pointer) {
+        return Table.sizes[_orders[getUnitIndex(pointer)]];
+    }
+};
+
+template <unsigned int MinOrder, unsigned int MaxOrder>
+constexpr typename BuddyAllocator<MinOrder, MaxOrder>::OrderTable BuddyAllocator<MinOrder, MaxOrder>::Table;
+
+
+#endif //BUDDY_ALLOCATION_BUDDYALLOCATOR_H
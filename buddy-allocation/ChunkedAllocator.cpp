@@ -0,0 +1,167 @@
+#include "ChunkedAllocator.h"
+
+#include <climits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+ChunkedAllocator::ChunkedAllocator() : ChunkedAllocator(CHUNK_DEFAULT_SIZE, ChunkPolicy{1, true}) {}
+
+ChunkedAllocator::ChunkedAllocator(size_t chunkSize, ChunkPolicy policy) {
+    _chunkSize = size_t(1) << MemoryAllocator::ceilLog2(chunkSize);
+    _policy = policy;
+    _current = nullptr;
+    _freeChunksCount = 0;
+    _releasedStats = {};
+}
+
+ChunkedAllocator::~ChunkedAllocator() {
+    for (auto &entry : _chunks) {
+        delete entry.second.allocator;
+        munmap(entry.second.memory, entry.second.size);
+    }
+}
+
+size_t ChunkedAllocator::getMappedSize() {
+    size_t size = 0;
+    for (auto &entry : _chunks) {
+        size += entry.second.size;
+    }
+    return size;
+}
+
+int ChunkedAllocator::getChunksCount() {
+    return int(_chunks.size());
+}
+
+AllocatorStats ChunkedAllocator::getStats() {
+    AllocatorStats stats = _releasedStats;
+    stats.bytesInUse = 0;
+    stats.bytesReserved = 0;
+    stats.largestFreeBlock = 0;
+    stats.osRequests = _osRequests.get();
+    for (auto &entry : _chunks) {
+        stats.add(entry.second.allocator->getStats());
+    }
+    return stats;
+}
+
+Chunk *ChunkedAllocator::addChunk(size_t size) {
+    // MemoryAllocator takes its size as an int
+    if (size > size_t(INT_MAX) || _chunkSize > size_t(INT_MAX)) {
+        return nullptr;
+    }
+    // requests above the chunk size get a dedicated, larger chunk
+    size = size > _chunkSize ? size_t(1) << MemoryAllocator::ceilLog2(size) : _chunkSize;
+    if (size > size_t(INT_MAX)) {
+        return nullptr;
+    }
+
+    auto *memory = (char *)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    _osRequests.add();
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+
+    Chunk &chunk = _chunks[memory];
+    chunk.memory = memory;
+    chunk.size = size;
+    chunk.allocator = new MemoryAllocator(memory, int(size), Measure::BYTE);
+    chunk.retained = false;
+    return &chunk;
+}
+
+Chunk *ChunkedAllocator::findChunk(void *pointer) {
+    auto entry = _chunks.upper_bound((char *)pointer);
+    if (entry == _chunks.begin()) {
+        return nullptr;
+    }
+    entry--;
+    Chunk &chunk = entry->second;
+    return (char *)pointer < chunk.memory + chunk.size ? &chunk : nullptr;
+}
+
+void ChunkedAllocator::releaseChunk(Chunk *chunk) {
+    if (_freeChunksCount < _policy.retainChunks) {
+        _freeChunksCount++;
+        chunk->retained = true;
+        if (_policy.adviseRetained) {
+            // the first page holds the free list node of the whole chunk
+            size_t page = size_t(sysconf(_SC_PAGESIZE));
+            if (chunk->size > page) {
+                madvise(chunk->memory + page, chunk->size - page, MADV_DONTNEED);
+                _osRequests.add();
+            }
+        }
+        return;
+    }
+
+    if (_current == chunk) {
+        _current = nullptr;
+    }
+    AllocatorStats released = chunk->allocator->getStats();
+    // a chunk's own mapping is counted here, not by its arena
+    released.bytesInUse = 0;
+    released.bytesReserved = 0;
+    released.largestFreeBlock = 0;
+    _releasedStats.add(released);
+
+    delete chunk->allocator;
+    munmap(chunk->memory, chunk->size);
+    _osRequests.add();
+    _chunks.erase(chunk->memory);
+}
+
+void *ChunkedAllocator::allocateFrom(Chunk *chunk, size_t size) {
+    void *pointer = chunk->allocator->allocate(size);
+    if (pointer != nullptr && chunk->retained) {
+        chunk->retained = false;
+        _freeChunksCount--;
+    }
+    return pointer;
+}
+
+void *ChunkedAllocator::allocate(size_t size) {
+    if (_current != nullptr) {
+        if (void *pointer = allocateFrom(_current, size)) {
+            return pointer;
+        }
+    }
+
+    for (auto &entry : _chunks) {
+        Chunk &chunk = entry.second;
+        if (&chunk == _current) {
+            continue;
+        }
+        if (void *pointer = allocateFrom(&chunk, size)) {
+            _current = &chunk;
+            return pointer;
+        }
+    }
+
+    Chunk *chunk = addChunk(size);
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    _current = chunk;
+    return chunk->allocator->allocate(size);
+}
+
+void ChunkedAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    Chunk *chunk = findChunk(pointer);
+    if (chunk == nullptr) {
+        // not allocated here, or its chunk is already released
+        return;
+    }
+    chunk->allocator->deallocate(pointer);
+    if (chunk->allocator->isUnused()) {
+        releaseChunk(chunk);
+    }
+}
+
+size_t ChunkedAllocator::getBlockSize(void *pointer) {
+    Chunk *chunk = findChunk(pointer);
+    return chunk != nullptr ? chunk->allocator->getBlockSize(pointer) : 0;
+}
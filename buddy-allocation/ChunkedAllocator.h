@@ -0,0 +1,68 @@
+#ifndef BUDDY_ALLOCATION_CHUNKEDALLOCATOR_H
+#define BUDDY_ALLOCATION_CHUNKEDALLOCATOR_H
+
+
+#include <cstddef>
+#include <map>
+#include "MemoryAllocator.h"
+
+#define CHUNK_DEFAULT_SIZE (4 * 1024 * 1024)
+
+// What happens to a chunk once coalescing makes it fully free.
+// Up to `retainChunks` free chunks are kept mapped (their interior pages
+// optionally handed back with MADV_DONTNEED); the rest are unmapped.
+struct ChunkPolicy {
+    int retainChunks;
+    bool adviseRetained;
+};
+
+struct Chunk {
+    char *memory;
+    size_t size;
+    MemoryAllocator *allocator;
+    // free and kept mapped by ChunkPolicy
+    bool retained;
+};
+
+// Buddy heap made of independently mmap'd top-level chunks: a chunk is
+// added when no existing one can satisfy a request and released again
+// according to ChunkPolicy when it becomes fully free.
+class ChunkedAllocator {
+private:
+    size_t _chunkSize;
+    ChunkPolicy _policy;
+    std::map<char *, Chunk> _chunks;
+    Chunk *_current;
+    int _freeChunksCount;
+    // counters of the chunks already unmapped
+    AllocatorStats _releasedStats;
+    StatCounter _osRequests;
+
+    Chunk *addChunk(size_t size);
+    Chunk *findChunk(void *pointer);
+    void releaseChunk(Chunk *chunk);
+    void *allocateFrom(Chunk *chunk, size_t size);
+
+public:
+    ChunkedAllocator();
+    ChunkedAllocator(size_t chunkSize, ChunkPolicy policy);
+    ChunkedAllocator(const ChunkedAllocator &) = delete;
+    ChunkedAllocator &operator=(const ChunkedAllocator &) = delete;
+    ~ChunkedAllocator();
+
+    size_t getMappedSize();
+    int getChunksCount();
+    // all chunks together, unmapped ones included; peaks are summed,
+    // so the peak is an upper bound
+    AllocatorStats getStats();
+
+    // nullptr for requests whose chunk would not fit MemoryAllocator's int size
+    void *allocate(size_t size);
+    // pointers of no chunk are ignored
+    void deallocate(void *pointer);
+    // 0 for pointers of no chunk
+    size_t getBlockSize(void *pointer);
+};
+
+
+#endif //BUDDY_ALLOCATION_CHUNKEDALLOCATOR_H
@@ -0,0 +1,246 @@
+#include "LockFreeAllocator.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+LockFreeAllocator::LockFreeAllocator() {
+    init(MEMORY_DEFAULT_SIZE_KB, Measure::K_BYTE);
+}
+
+LockFreeAllocator::LockFreeAllocator(int size, Measure measure) {
+    init(size, measure);
+}
+
+LockFreeAllocator::~LockFreeAllocator() {
+    for (int i = 0; i < _listsCount; i++) {
+        delete[] _freeMaps[i];
+        delete[] _summaries[i];
+    }
+    delete[] _freeMaps;
+    delete[] _summaries;
+    delete[] _wordsCount;
+    delete[] _freeCounts;
+    delete[] _publishes;
+    delete[] _orders;
+    std::free(_memory);
+}
+
+void LockFreeAllocator::init(int size, Measure measure) {
+    _size = MemoryAllocator::calcSize(size, measure);
+
+    _minBlockShift = MemoryAllocator::ceilLog2((unsigned long)BLOCK_MIN_SIZE * measure);
+    _unitsCount = _size >> _minBlockShift;
+    _listsCount = _unitsCount == 0 ? 0 : MemoryAllocator::floorLog2(_unitsCount) + 1;
+
+    _memory = (char *)malloc(_size);
+    if (_memory == nullptr) {
+        std::cerr << "Error: Out of memory\n";
+        exit(EXIT_SUCCESS);
+    }
+
+    _freeMaps = new std::atomic<uint64_t> *[_listsCount];
+    _wordsCount = new unsigned long[_listsCount];
+    _summaries = new std::atomic<uint64_t> *[_listsCount];
+    _freeCounts = new std::atomic<long>[_listsCount];
+    _publishes = new std::atomic<unsigned long>[_listsCount];
+    for (int i = 0; i < _listsCount; i++) {
+        _freeCounts[i].store(0, std::memory_order_relaxed);
+        _publishes[i].store(0, std::memory_order_relaxed);
+        _wordsCount[i] = ((_unitsCount >> i) + 63) / 64;
+        _freeMaps[i] = new std::atomic<uint64_t>[_wordsCount[i]];
+        for (unsigned long word = 0; word < _wordsCount[i]; word++) {
+            _freeMaps[i][word].store(0, std::memory_order_relaxed);
+        }
+        unsigned long summaryWords = (_wordsCount[i] + 63) / 64;
+        _summaries[i] = new std::atomic<uint64_t>[summaryWords];
+        for (unsigned long word = 0; word < summaryWords; word++) {
+            _summaries[i][word].store(0, std::memory_order_relaxed);
+        }
+    }
+    _orders = new unsigned char[_unitsCount]();
+
+    unsigned long index = 0;
+    for (int i = _listsCount - 1; i >= 0; i--) {
+        if (index + (1uL << i) <= _unitsCount) {
+            publish(i, index);
+            index += 1uL << i;
+        }
+    }
+}
+
+unsigned long LockFreeAllocator::getSize() {
+    return _size;
+}
+
+char *LockFreeAllocator::getMemoryPointer() {
+    return _memory;
+}
+
+int LockFreeAllocator::getListsCount() {
+    return _listsCount;
+}
+
+int LockFreeAllocator::getOrder(size_t size) {
+    if (size > (_unitsCount << _minBlockShift)) {
+        return _listsCount;
+    }
+    int shift = MemoryAllocator::ceilLog2(size);
+    return shift > int(_minBlockShift) ? shift - int(_minBlockShift) : 0;
+}
+
+size_t LockFreeAllocator::getOrderSize(int order) {
+    return size_t(1) << (_minBlockShift + order);
+}
+
+size_t LockFreeAllocator::getBlockSize(void *pointer) {
+    return getOrderSize(getBlockOrder(pointer));
+}
+
+int LockFreeAllocator::getBlockOrder(void *pointer) {
+    return _orders[getUnitIndex((char *)pointer)];
+}
+
+unsigned long LockFreeAllocator::getUnitIndex(char *address) {
+    return (unsigned long)(address - _memory) >> _minBlockShift;
+}
+
+char *LockFreeAllocator::getUnitAddress(unsigned long index) {
+    return _memory + (index << _minBlockShift);
+}
+
+bool LockFreeAllocator::hasBuddy(int listIndex, unsigned long index) {
+    unsigned long buddy = index ^ (1uL << listIndex);
+    return listIndex < _listsCount - 1 && buddy + (1uL << listIndex) <= _unitsCount;
+}
+
+bool LockFreeAllocator::isFree(int listIndex, unsigned long index) {
+    unsigned long bit = index >> listIndex;
+    return (_freeMaps[listIndex][bit / 64].load() >> (bit % 64)) & 1u;
+}
+
+bool LockFreeAllocator::claim(int listIndex, unsigned long index) {
+    unsigned long bit = index >> listIndex;
+    uint64_t mask = uint64_t(1) << (bit % 64);
+    if (_freeMaps[listIndex][bit / 64].fetch_and(~mask) & mask) {
+        _freeCounts[listIndex].fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool LockFreeAllocator::claimAny(int listIndex, unsigned long &index) {
+    if (_freeCounts[listIndex].load(std::memory_order_relaxed) <= 0) {
+        return false;
+    }
+
+    std::atomic<uint64_t> *map = _freeMaps[listIndex];
+    std::atomic<uint64_t> *summary = _summaries[listIndex];
+    unsigned long summaryWords = (_wordsCount[listIndex] + 63) / 64;
+    for (unsigned long group = 0; group < summaryWords; group++) {
+        uint64_t words = summary[group].load(std::memory_order_relaxed);
+        while (words != 0) {
+            unsigned long word = group * 64 + __builtin_ctzll(words);
+            uint64_t value = map[word].load(std::memory_order_relaxed);
+            while (value != 0) {
+                uint64_t mask = value & -value;
+                if (map[word].compare_exchange_weak(value, value & ~mask)) {
+                    _freeCounts[listIndex].fetch_sub(1, std::memory_order_relaxed);
+                    index = (word * 64 + __builtin_ctzll(mask)) << listIndex;
+                    return true;
+                }
+            }
+
+            // The word ran empty: drop its summary bit, then look again in
+            // case a block was published in between and restore the bit.
+            uint64_t wordMask = uint64_t(1) << (word % 64);
+            summary[group].fetch_and(~wordMask);
+            if (map[word].load() != 0) {
+                summary[group].fetch_or(wordMask);
+            }
+            words &= words - 1;
+        }
+    }
+    return false;
+}
+
+void LockFreeAllocator::publish(int listIndex, unsigned long index) {
+    unsigned long bit = index >> listIndex;
+    _freeMaps[listIndex][bit / 64].fetch_or(uint64_t(1) << (bit % 64));
+    _summaries[listIndex][bit / 4096].fetch_or(uint64_t(1) << (bit / 64 % 64));
+    _freeCounts[listIndex].fetch_add(1, std::memory_order_relaxed);
+    _publishes[listIndex].fetch_add(1, std::memory_order_relaxed);
+}
+
+// only compared with an earlier count, so relaxed loads do
+unsigned long LockFreeAllocator::countPublishes(int listIndex) {
+    unsigned long count = 0;
+    for (int i = listIndex; i < _listsCount; i++) {
+        count += _publishes[i].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+void *LockFreeAllocator::allocate(size_t size) {
+    int targetIndex = getOrder(size);
+    if (targetIndex >= _listsCount) {
+        return nullptr;
+    }
+
+    unsigned long publishes = countPublishes(targetIndex);
+    for (int attempt = 1; ; attempt++) {
+        unsigned long index;
+        if (claimAny(targetIndex, index)) {
+            _orders[index] = (unsigned char)targetIndex;
+            return getUnitAddress(index);
+        }
+
+        int listIndex = targetIndex + 1;
+        while (listIndex < _listsCount && !claimAny(listIndex, index)) {
+            listIndex++;
+        }
+        if (listIndex < _listsCount) {
+            // the claimed block is private: publish upper halves on the way down
+            while (listIndex > targetIndex) {
+                listIndex--;
+                publish(listIndex, index + (1uL << listIndex));
+            }
+            _orders[index] = (unsigned char)targetIndex;
+            return getUnitAddress(index);
+        }
+
+        if (attempt == LOCK_FREE_ATTEMPTS) {
+            return nullptr;
+        }
+        unsigned long seen = publishes;
+        publishes = countPublishes(targetIndex);
+        if (publishes == seen) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void LockFreeAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    unsigned long index = getUnitIndex((char *)pointer);
+    int listIndex = _orders[index];
+
+    for (;;) {
+        // claiming the buddy makes the merged block private to this thread
+        while (hasBuddy(listIndex, index) && claim(listIndex, index ^ (1uL << listIndex))) {
+            index &= ~(1uL << listIndex);
+            listIndex++;
+        }
+        publish(listIndex, index);
+
+        // A buddy freed concurrently may have checked us before we were
+        // published; if it is visible now, take our block back and merge.
+        if (!hasBuddy(listIndex, index) ||
+            !isFree(listIndex, index ^ (1uL << listIndex)) ||
+            !claim(listIndex, index)) {
+            break;
+        }
+    }
+}
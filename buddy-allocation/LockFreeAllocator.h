@@ -0,0 +1,73 @@
+#ifndef BUDDY_ALLOCATION_LOCKFREEALLOCATOR_H
+#define BUDDY_ALLOCATION_LOCKFREEALLOCATOR_H
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "MemoryAllocator.h"
+
+// scans a failing allocation makes before it gives up
+#define LOCK_FREE_ATTEMPTS 8
+
+// Buddy allocator whose whole state is a tree of atomic bits: bit `index >> i`
+// of `_freeMaps[i]` is set while the order `i` block at unit `index` is free.
+// Blocks are claimed by atomically clearing their bit and published by setting
+// it, so alloc and free never block and a block can only be claimed once.
+class LockFreeAllocator {
+private:
+    unsigned long _size;
+    int _listsCount;
+    char *_memory;
+
+    unsigned int _minBlockShift;
+    unsigned long _unitsCount;
+    std::atomic<uint64_t> **_freeMaps;
+    unsigned long *_wordsCount;
+
+    // One summary bit per bitmap word that may hold free blocks, and
+    // free counts that let empty orders be skipped without a scan.
+    std::atomic<uint64_t> **_summaries;
+    std::atomic<long> *_freeCounts;
+    unsigned char *_orders;
+
+    // Blocks published per order. A scan that found nothing is retried
+    // at once if blocks of a large enough order were published meanwhile;
+    // otherwise the thread yields first, since a split or merge in flight
+    // may hold the block it needs. Either way it gives up after
+    // LOCK_FREE_ATTEMPTS scans, so it never waits on another thread.
+    std::atomic<unsigned long> *_publishes;
+
+    void init(int size, Measure measure);
+
+    unsigned long getUnitIndex(char *address);
+    char *getUnitAddress(unsigned long index);
+    bool hasBuddy(int listIndex, unsigned long index);
+
+    bool isFree(int listIndex, unsigned long index);
+    bool claim(int listIndex, unsigned long index);
+    bool claimAny(int listIndex, unsigned long &index);
+    void publish(int listIndex, unsigned long index);
+    unsigned long countPublishes(int listIndex);
+
+public:
+    LockFreeAllocator();
+    LockFreeAllocator(int size, Measure measure);
+    LockFreeAllocator(const LockFreeAllocator &) = delete;
+    LockFreeAllocator &operator=(const LockFreeAllocator &) = delete;
+    ~LockFreeAllocator();
+
+    unsigned long getSize();
+    char *getMemoryPointer();
+
+    void *allocate(size_t size);
+    void deallocate(void *pointer);
+    size_t getBlockSize(void *pointer);
+    int getBlockOrder(void *pointer);
+    int getOrder(size_t size);
+    size_t getOrderSize(int order);
+    int getListsCount();
+};
+
+
+#endif //BUDDY_ALLOCATION_LOCKFREEALLOCATOR_H
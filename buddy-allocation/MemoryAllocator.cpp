@@ -1,44 +1,93 @@
 #include "MemoryAllocator.h"
 
 #include <iostream>
-#include <cmath>
 #include <cstdlib>
 #include <iomanip>
 
+#ifdef ALLOCATION_TRACE
+#include "trace.h"
+#endif
+#ifdef HEAP_PROFILE
+#include "profile.h"
+#endif
+
 MemoryAllocator::MemoryAllocator() {
-    init(MEMORY_DEFAULT_SIZE_KB, Measure::K_BYTE);
+    init(MEMORY_DEFAULT_SIZE_KB, Measure::K_BYTE, nullptr);
 }
 
 MemoryAllocator::MemoryAllocator(int size, Measure measure) {
-    init(size, measure);
+    init(size, measure, nullptr);
+}
+
+MemoryAllocator::MemoryAllocator(char *memory, int size, Measure measure) {
+    init(size, measure, memory);
+}
+
+MemoryAllocator::~MemoryAllocator() {
+    for (int i = 0; i < int(_listsCount); i++) {
+        delete[] _freeMaps[i];
+    }
+    delete[] _freeMaps;
+    delete[] _orders;
+    delete[] _blocks;
+    if (_ownsMemory) {
+        std::free(_memory);
+    }
 }
 
-void MemoryAllocator::init(int size, Measure measure) {
+void MemoryAllocator::init(int size, Measure measure, char *memory) {
     _measure = measure;
     _size = MemoryAllocator::calcSize(size, measure);
-    _listsCount = getMeasuredSize();
 
-    _memory = (char *)malloc(_size);
+    _minBlockShift = ceilLog2((unsigned long)BLOCK_MIN_SIZE * _measure);
+    _unitsCount = _size >> _minBlockShift;
+    _listsCount = _unitsCount == 0 ? 0 : floorLog2(_unitsCount) + 1;
+    _nonEmptyOrders = 0;
+    _usedUnits = 0;
+    _remoteFrees.store(nullptr, std::memory_order_relaxed);
+
+    _ownsMemory = memory == nullptr;
+    _memory = _ownsMemory ? (char *)malloc(_size) : memory;
     if (_memory == nullptr) {
         std::cerr << "Error: Out of memory\n";
         exit(EXIT_SUCCESS);
     }
 
     _blocks = new BlocksList[_listsCount];
-    for (int i = 0; i < _listsCount; i++) {
+    _freeMaps = new uint64_t *[_listsCount];
+    for (int i = 0; i < int(_listsCount); i++) {
         _blocks[i] = BlocksList(MemoryAllocator::calcBlockSize(i));
+
+        unsigned long words = ((_unitsCount >> i) + 63) / 64;
+        _freeMaps[i] = new uint64_t[words]();
     }
+    _orders = new unsigned char[_unitsCount]();
 
-    auto measuredSize = int(getMeasuredSize());
-    _blocks[getListIndex(measuredSize)].push(_memory);
+    // A size that is not a power of two is covered by aligned
+    // top-level blocks of decreasing order; they never have a buddy.
+    unsigned long index = 0;
+    for (int i = int(_listsCount) - 1; i >= 0; i--) {
+        if (index + (1uL << i) <= _unitsCount) {
+            pushFree(i, index);
+            index += 1uL << i;
+        }
+    }
 }
 
 int MemoryAllocator::getListsCount() {
-    return getListIndex(int(getMeasuredSize())) + 1;
+    return int(_listsCount);
+}
+
+int MemoryAllocator::getOrder(size_t size) {
+    if (size > (_unitsCount << _minBlockShift)) {
+        return getListsCount();
+    }
+    int shift = ceilLog2(size);
+    return shift > int(_minBlockShift) ? shift - int(_minBlockShift) : 0;
 }
 
-int MemoryAllocator::getListIndex(int size) {
-    return ceil(log2(size) - log2(BLOCK_MIN_SIZE));
+size_t MemoryAllocator::getOrderSize(int order) {
+    return size_t(1) << (_minBlockShift + order);
 }
 
 unsigned long MemoryAllocator::getSize() {
@@ -49,63 +98,71 @@ unsigned long MemoryAllocator::getMeasuredSize() {
     return _size / _measure;
 }
 
-void MemoryAllocator::sortList(int listIndex) {
-    BlocksList unsorted = _blocks[listIndex];
-    BlocksList sorted = BlocksList(unsorted.getBlockSize());
-    sorted.unshift(unsorted.get(0)->address);
-
-    for (int i = 1; i < unsorted.getLength(); i++) {
-        void *insertAddress = unsorted.get(i)->address;
-        for (int j = 0; j < sorted.getLength(); j++) {
-            if (insertAddress <= (sorted.get(j)->address)) {
-                sorted.unshift(insertAddress);
-                break;
-            } else if (
-                j == sorted.getLength() - 1 &&
-                insertAddress > (sorted.get(j)->address)
-            ) {
-                sorted.push(insertAddress);
-                break;
-            }
-        }
-    }
+unsigned long MemoryAllocator::getUsedSize() {
+    drainRemoteFrees();
+    return _usedUnits << _minBlockShift;
+}
 
-    _blocks[listIndex] = sorted;
+bool MemoryAllocator::isUnused() {
+    drainRemoteFrees();
+    return _usedUnits == 0;
 }
 
-int *MemoryAllocator::findBuddies(int listIndex) {
-    BlocksList list = _blocks[listIndex];
-    if (list.getLength() > 1) {
-        int *buddies = (int *)malloc(sizeof(int) * 2);
-        int blockSize = list.getBlockSize() * _measure;
-        for (int i = 0; i <= list.getLength() - 2; i++) {
-            if (list.get(i)->address == (char *) list.get(i + 1)->address - blockSize) {
-                buddies[0] = i;
-                buddies[1] = i + 1;
-                return buddies;
-            }
-        }
+AllocatorStats MemoryAllocator::getStats() {
+    AllocatorStats stats = {};
+    for (int i = 0; i < getListsCount(); i++) {
+        stats.allocations[i] = _allocations[i].get();
+        stats.frees[i] = _frees[i].get();
     }
-    return nullptr;
+    stats.failedAllocations = _failedAllocations.get();
+    stats.bytesInUse = getUsedSize();
+    stats.peakBytesInUse = _peakUnits.get() << _minBlockShift;
+    stats.bytesReserved = _size;
+    stats.splits = _splits.get();
+    stats.merges = _merges.get();
+    // the arena itself, when it allocated its memory
+    stats.osRequests = _ownsMemory ? 1 : 0;
+    stats.largestFreeBlock = _nonEmptyOrders == 0 ? 0 : getOrderSize(floorLog2(_nonEmptyOrders));
+    return stats;
 }
 
-void MemoryAllocator::merge(int listIndex) {
-    int *buddies = findBuddies(listIndex);
-    while (buddies != nullptr) {
-        void* startAddress = _blocks[listIndex].get(buddies[0])->address;
-        _blocks[listIndex].remove(buddies[1]);
-        _blocks[listIndex].remove(buddies[0]);
-        _blocks[listIndex + 1].unshift(startAddress);
-        sortList(listIndex + 1);
+unsigned long MemoryAllocator::getUnitIndex(char *address) {
+    return (unsigned long)(address - _memory) >> _minBlockShift;
+}
 
-        buddies = findBuddies(listIndex);
+char *MemoryAllocator::getUnitAddress(unsigned long index) {
+    return _memory + (index << _minBlockShift);
+}
+
+bool MemoryAllocator::isFree(int listIndex, unsigned long index) {
+    unsigned long bit = index >> listIndex;
+    return (_freeMaps[listIndex][bit / 64] >> (bit % 64)) & 1u;
+}
+
+void MemoryAllocator::pushFree(int listIndex, unsigned long index) {
+    unsigned long bit = index >> listIndex;
+    _freeMaps[listIndex][bit / 64] |= uint64_t(1) << (bit % 64);
+    _blocks[listIndex].unshift(getUnitAddress(index));
+    _nonEmptyOrders |= uint64_t(1) << listIndex;
+}
+
+void MemoryAllocator::removeFree(int listIndex, unsigned long index) {
+    unsigned long bit = index >> listIndex;
+    _freeMaps[listIndex][bit / 64] &= ~(uint64_t(1) << (bit % 64));
+    _blocks[listIndex].remove(getUnitAddress(index));
+    if (_blocks[listIndex].isEmpty()) {
+        _nonEmptyOrders &= ~(uint64_t(1) << listIndex);
     }
 }
 
-void MemoryAllocator::mergeAll() {
-    for (int i = 0; i < int(_listsCount); i++) {
-        merge(i);
+unsigned long MemoryAllocator::popFree(int listIndex) {
+    unsigned long index = getUnitIndex((char *)_blocks[listIndex].shift());
+    if (_blocks[listIndex].isEmpty()) {
+        _nonEmptyOrders &= ~(uint64_t(1) << listIndex);
     }
+    unsigned long bit = index >> listIndex;
+    _freeMaps[listIndex][bit / 64] &= ~(uint64_t(1) << (bit % 64));
+    return index;
 }
 
 void MemoryAllocator::dump() {
@@ -122,56 +179,128 @@ char *MemoryAllocator::getMemoryPointer() {
     return _memory;
 }
 
-Block *MemoryAllocator::alloc(int size) {
-    int listIndex = getListIndex(size);
-    bool found = false;
-
-    auto *allocatedBlock = new ListBlock;
-    while (!found) {
-        if (_blocks[listIndex].getLength() > 0) {
-            allocatedBlock = _blocks[listIndex].get(0);
-            _blocks[listIndex].remove(0);
-            found = true;
-        } else if (listIndex < _listsCount) {
-            listIndex++;
-            if (_blocks[listIndex].getLength() > 0) {
-                auto *blockToSplit = new ListBlock;
-                blockToSplit = _blocks[listIndex].get(0);
-                _blocks[listIndex - 1].unshift((
-                    (char *) blockToSplit->address + (_blocks[listIndex - 1].getBlockSize() * _measure)
-                ));
-                _blocks[listIndex - 1].unshift(blockToSplit->address);
-                _blocks[listIndex].remove(0);
-                listIndex = getListIndex(size);
-            }
-        } else {
+void *MemoryAllocator::allocate(size_t size) {
+    drainRemoteFrees();
+
+    int targetIndex = getOrder(size);
+    if (targetIndex >= getListsCount()) {
+        _failedAllocations.add();
+        return nullptr;
+    }
+
+    // smallest nonempty order that can hold the request
+    uint64_t usable = _nonEmptyOrders & (~uint64_t(0) << targetIndex);
+    if (usable == 0) {
+        _failedAllocations.add();
+        return nullptr;
+    }
+    int listIndex = __builtin_ctzll(usable);
+
+    // split straight down to the requested order, keeping upper halves
+    unsigned long index = popFree(listIndex);
+    _splits.add(listIndex - targetIndex);
+    while (listIndex > targetIndex) {
+        listIndex--;
+        pushFree(listIndex, index + (1uL << listIndex));
+    }
+
+    _orders[index] = (unsigned char)targetIndex;
+    _usedUnits += 1uL << targetIndex;
+    _allocations[targetIndex].add();
+    _peakUnits.raise(_usedUnits);
+    char *address = getUnitAddress(index);
+#ifdef ALLOCATION_TRACE
+    trace_alloc(address, size);
+#endif
+#ifdef HEAP_PROFILE
+    heap_profile_alloc(address, size);
+#endif
+    return address;
+}
+
+void MemoryAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+#ifdef ALLOCATION_TRACE
+    trace_free(pointer);
+#endif
+#ifdef HEAP_PROFILE
+    heap_profile_free(pointer);
+#endif
+    unsigned long index = getUnitIndex((char *)pointer);
+    int listIndex = _orders[index];
+    _usedUnits -= 1uL << listIndex;
+    _frees[listIndex].add();
+    int order = listIndex;
+
+    // climb the block's own chain while its buddy is free
+    while (listIndex < getListsCount() - 1) {
+        unsigned long buddy = index ^ (1uL << listIndex);
+        if (buddy + (1uL << listIndex) > _unitsCount || !isFree(listIndex, buddy)) {
             break;
         }
+        removeFree(listIndex, buddy);
+        index &= ~(1uL << listIndex);
+        listIndex++;
     }
+    _merges.add(listIndex - order);
+    pushFree(listIndex, index);
+}
 
-    if (found) {
-        auto *foundBlock = new Block;
-        foundBlock->startAddress = (char *) allocatedBlock->address;
-        foundBlock->size = _blocks[listIndex].getBlockSize();
-        return foundBlock;
-    } else {
+void MemoryAllocator::deallocateRemote(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    auto *block = (ListBlock *)pointer;
+    ListBlock *head = _remoteFrees.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!_remoteFrees.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void MemoryAllocator::drainRemoteFrees() {
+    if (_remoteFrees.load(std::memory_order_relaxed) == nullptr) {
+        return;
+    }
+    // the single consumer takes the whole stack, so there is no ABA
+    ListBlock *block = _remoteFrees.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+        ListBlock *next = block->next;
+        deallocate(block);
+        block = next;
+    }
+}
+
+size_t MemoryAllocator::getBlockSize(void *pointer) {
+    return getOrderSize(getBlockOrder(pointer));
+}
+
+int MemoryAllocator::getBlockOrder(void *pointer) {
+    return _orders[getUnitIndex((char *)pointer)];
+}
+
+Block *MemoryAllocator::alloc(int size) {
+    void *pointer = allocate(calcSize(size, _measure));
+    if (pointer == nullptr) {
         return nullptr;
     }
+
+    auto *foundBlock = new Block;
+    foundBlock->startAddress = (char *)pointer;
+    foundBlock->size = getBlockSize(pointer) / _measure;
+    return foundBlock;
 }
 
 void MemoryAllocator::free(Block *freeBlock) {
-    int listIndex = getListIndex(int(freeBlock->size));
-    _blocks[listIndex].unshift(freeBlock->startAddress);
-    sortList(listIndex);
-    mergeAll();
+    deallocate(freeBlock->startAddress);
+    delete freeBlock;
 }
 
 unsigned long MemoryAllocator::calcSize(int size, Measure measure) {
-    return size * measure * sizeof(char);
+    return (unsigned long)size * measure * sizeof(char);
 }
 
 int MemoryAllocator::calcBlockSize(int index) {
-    return pow(2, index + log2(BLOCK_MIN_SIZE));
+    return BLOCK_MIN_SIZE << index;
 }
-
-
@@ -2,6 +2,10 @@
 #define BUDDY_ALLOCATION_MEMORYALLOCATOR_H
 
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "AllocatorStats.h"
 #include "BlocksList.h"
 
 #define MEMORY_DEFAULT_SIZE_KB 1024
@@ -12,10 +16,12 @@ struct Block {
     unsigned int size;
 };
 
+// Binary multiples keep every block size a power of two in bytes,
+// so a buddy is found by XOR-ing the block offset with its size.
 enum Measure {
     BYTE = 1,
-    K_BYTE = 1000,
-    M_BYTE = 1000000
+    K_BYTE = 1024,
+    M_BYTE = 1024 * 1024
 };
 
 class MemoryAllocator {
@@ -23,33 +29,91 @@ private:
     unsigned long _size;
     unsigned long _listsCount;
     char *_memory;
+    bool _ownsMemory;
     BlocksList *_blocks;
     Measure _measure;
 
-    void init(int size, Measure measure);
+    // Free blocks are tracked in units of the minimal block:
+    // a block of order `i` starting at unit `index` owns bit `index >> i`
+    // of `_freeMaps[i]`, and its list node is stored inside the block.
+    unsigned int _minBlockShift;
+    unsigned long _unitsCount;
+    uint64_t **_freeMaps;
 
-    int getListsCount();
-    static int getListIndex(int size);
+    // Bit `i` is set while the order `i` free list is not empty.
+    uint64_t _nonEmptyOrders;
+
+    // Order of every allocated block, one byte per unit,
+    // read back by deallocate() from the block's first unit.
+    unsigned char *_orders;
+    unsigned long _usedUnits;
+
+    // Blocks freed by other threads, pushed without a lock and linked
+    // through ListBlock::next; the owner takes them all on its next
+    // allocate(), or when it asks for the used size.
+    std::atomic<ListBlock *> _remoteFrees;
+
+    // event counters reported by getStats()
+    StatCounter _allocations[STATS_ORDERS];
+    StatCounter _frees[STATS_ORDERS];
+    StatCounter _failedAllocations;
+    StatCounter _peakUnits;
+    StatCounter _splits;
+    StatCounter _merges;
+
+    void init(int size, Measure measure, char *memory);
 
-    void sortList(int listIndex);
-    int *findBuddies(int listIndex);
+    unsigned long getUnitIndex(char *address);
+    char *getUnitAddress(unsigned long index);
 
-    void merge(int listIndex);
-    void mergeAll();
+    bool isFree(int listIndex, unsigned long index);
+    void pushFree(int listIndex, unsigned long index);
+    void removeFree(int listIndex, unsigned long index);
+    unsigned long popFree(int listIndex);
+
+    void drainRemoteFrees();
 
 public:
     MemoryAllocator();
     MemoryAllocator(int sizeKb, Measure measure);
+    // Manages caller-provided memory (e.g. a mapping) without owning it.
+    MemoryAllocator(char *memory, int size, Measure measure);
+    MemoryAllocator(const MemoryAllocator &) = delete;
+    MemoryAllocator &operator=(const MemoryAllocator &) = delete;
+    ~MemoryAllocator();
 
     static unsigned long calcSize(int size, Measure measure);
     static int calcBlockSize(int index);
 
+    static int floorLog2(uint64_t value) {
+        return 63 - __builtin_clzll(value);
+    }
+    static int ceilLog2(uint64_t value) {
+        return value <= 1 ? 0 : 64 - __builtin_clzll(value - 1);
+    }
+
     unsigned long getSize();
     unsigned long getMeasuredSize();
+    unsigned long getUsedSize();
+    bool isUnused();
+    // Counters may be read from any thread; bytes in use and the largest
+    // free block come from the arena itself, so call this from the thread
+    // using the arena or under its lock.
+    AllocatorStats getStats();
 
     void dump();
     char *getMemoryPointer();
 
+    void *allocate(size_t size);
+    void deallocate(void *pointer);
+    // Safe from any thread while the owner keeps allocating.
+    void deallocateRemote(void *pointer);
+    size_t getBlockSize(void *pointer);
+    int getBlockOrder(void *pointer);
+    int getOrder(size_t size);
+    size_t getOrderSize(int order);
+    int getListsCount();
+
     Block *alloc(int size);
     void free(Block *freeBlock);
 };
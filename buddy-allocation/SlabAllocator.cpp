@@ -0,0 +1,153 @@
+#include "SlabAllocator.h"
+
+const size_t SlabAllocator::ClassSizes[SLAB_CLASSES_COUNT] = {
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256
+};
+
+SlabAllocator::SlabAllocator(MemoryAllocator &allocator) : _allocator(allocator) {
+    _slabSize = _allocator.getOrderSize(_allocator.getOrder(SLAB_SIZE));
+    _slabShift = MemoryAllocator::floorLog2(_slabSize);
+    _slabRegions = new unsigned char[(_allocator.getSize() >> _slabShift) + 1]();
+    for (auto &slab : _partial) {
+        slab = nullptr;
+    }
+}
+
+SlabAllocator::~SlabAllocator() {
+    for (auto slab : _partial) {
+        if (slab != nullptr && slab->freeCount == getCapacity(slab->classIndex)) {
+            releaseSlab(slab);
+        }
+    }
+    delete[] _slabRegions;
+}
+
+int SlabAllocator::getClassIndex(size_t size) {
+    if (size <= 128) {
+        return size == 0 ? 0 : int((size - 1) / 16);
+    }
+    return 8 + int((size - 129) / 32);
+}
+
+size_t SlabAllocator::getObjectsOffset() {
+    return (sizeof(Slab) + 15) & ~size_t(15);
+}
+
+unsigned int SlabAllocator::getCapacity(unsigned int classIndex) {
+    size_t capacity = (_slabSize - getObjectsOffset()) / ClassSizes[classIndex];
+    return capacity < SLAB_MAX_OBJECTS ? (unsigned int)capacity : SLAB_MAX_OBJECTS;
+}
+
+unsigned long SlabAllocator::getReservedSize() {
+    return _allocator.getUsedSize();
+}
+
+Slab *SlabAllocator::findSlab(void *pointer) {
+    char *memory = _allocator.getMemoryPointer();
+    unsigned long region = (unsigned long)((char *)pointer - memory) >> _slabShift;
+    if (!_slabRegions[region]) {
+        return nullptr;
+    }
+    return (Slab *)(memory + (region << _slabShift));
+}
+
+void SlabAllocator::linkPartial(Slab *slab) {
+    slab->prev = nullptr;
+    slab->next = _partial[slab->classIndex];
+    if (slab->next != nullptr) {
+        slab->next->prev = slab;
+    }
+    _partial[slab->classIndex] = slab;
+}
+
+void SlabAllocator::unlinkPartial(Slab *slab) {
+    if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+    } else {
+        _partial[slab->classIndex] = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+Slab *SlabAllocator::createSlab(unsigned int classIndex) {
+    auto *slab = (Slab *)_allocator.allocate(_slabSize);
+    if (slab == nullptr) {
+        return nullptr;
+    }
+
+    unsigned int capacity = getCapacity(classIndex);
+    slab->classIndex = classIndex;
+    slab->freeCount = capacity;
+    for (unsigned int word = 0; word < SLAB_MAX_OBJECTS / 64; word++) {
+        unsigned int bits = capacity > word * 64 ? capacity - word * 64 : 0;
+        slab->freeMap[word] = bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+
+    _slabRegions[((char *)slab - _allocator.getMemoryPointer()) >> _slabShift] = 1;
+    linkPartial(slab);
+    return slab;
+}
+
+void SlabAllocator::releaseSlab(Slab *slab) {
+    unlinkPartial(slab);
+    _slabRegions[((char *)slab - _allocator.getMemoryPointer()) >> _slabShift] = 0;
+    _allocator.deallocate(slab);
+}
+
+void *SlabAllocator::allocate(size_t size) {
+    if (size > SLAB_MAX_OBJECT_SIZE) {
+        return _allocator.allocate(size);
+    }
+
+    unsigned int classIndex = getClassIndex(size);
+    Slab *slab = _partial[classIndex];
+    if (slab == nullptr) {
+        slab = createSlab(classIndex);
+        if (slab == nullptr) {
+            return nullptr;
+        }
+    }
+
+    // a partial slab always has a free slot: find-first-set over its map
+    unsigned int word = 0;
+    while (slab->freeMap[word] == 0) {
+        word++;
+    }
+    unsigned int bit = __builtin_ctzll(slab->freeMap[word]);
+    slab->freeMap[word] &= slab->freeMap[word] - 1;
+    if (--slab->freeCount == 0) {
+        unlinkPartial(slab);
+    }
+
+    return (char *)slab + getObjectsOffset() + (word * 64 + bit) * ClassSizes[classIndex];
+}
+
+void SlabAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    Slab *slab = findSlab(pointer);
+    if (slab == nullptr) {
+        _allocator.deallocate(pointer);
+        return;
+    }
+
+    size_t slot = size_t((char *)pointer - (char *)slab - getObjectsOffset()) / ClassSizes[slab->classIndex];
+    slab->freeMap[slot / 64] |= uint64_t(1) << (slot % 64);
+    if (slab->freeCount++ == 0) {
+        linkPartial(slab);
+    }
+
+    // keep the last partial slab of a class to avoid create/release ping-pong
+    if (slab->freeCount == getCapacity(slab->classIndex) &&
+        (slab->prev != nullptr || slab->next != nullptr)) {
+        releaseSlab(slab);
+    }
+}
+
+size_t SlabAllocator::getBlockSize(void *pointer) {
+    Slab *slab = findSlab(pointer);
+    return slab != nullptr ? ClassSizes[slab->classIndex] : _allocator.getBlockSize(pointer);
+}
@@ -0,0 +1,64 @@
+#ifndef BUDDY_ALLOCATION_SLABALLOCATOR_H
+#define BUDDY_ALLOCATION_SLABALLOCATOR_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include "MemoryAllocator.h"
+
+#define SLAB_SIZE 4096
+#define SLAB_MAX_OBJECT_SIZE 256
+#define SLAB_CLASSES_COUNT 12
+#define SLAB_MAX_OBJECTS 256
+
+// Header at the start of every slab; objects of one size class follow it.
+// A set bit in `freeMap` marks a free object slot.
+struct Slab {
+    Slab *prev;
+    Slab *next;
+    unsigned int classIndex;
+    unsigned int freeCount;
+    uint64_t freeMap[SLAB_MAX_OBJECTS / 64];
+};
+
+// Small-object front end: requests up to SLAB_MAX_OBJECT_SIZE bytes are
+// served from slabs carved out of MemoryAllocator blocks, larger ones go
+// to the buddy allocator directly. Empty slabs are handed back, except
+// for the last partial slab of a class.
+class SlabAllocator {
+private:
+    MemoryAllocator &_allocator;
+    size_t _slabSize;
+    unsigned int _slabShift;
+    // One flag per slab-sized region of the arena, set while it is a slab.
+    unsigned char *_slabRegions;
+    Slab *_partial[SLAB_CLASSES_COUNT];
+
+    static int getClassIndex(size_t size);
+    static size_t getObjectsOffset();
+    unsigned int getCapacity(unsigned int classIndex);
+
+    Slab *findSlab(void *pointer);
+    Slab *createSlab(unsigned int classIndex);
+    void releaseSlab(Slab *slab);
+    void linkPartial(Slab *slab);
+    void unlinkPartial(Slab *slab);
+
+public:
+    static const size_t ClassSizes[SLAB_CLASSES_COUNT];
+
+    explicit SlabAllocator(MemoryAllocator &allocator);
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+    ~SlabAllocator();
+
+    // Bytes taken from the buddy allocator, slabs and direct blocks alike.
+    unsigned long getReservedSize();
+
+    void *allocate(size_t size);
+    void deallocate(void *pointer);
+    size_t getBlockSize(void *pointer);
+};
+
+
+#endif //BUDDY_ALLOCATION_SLABALLOCATOR_H
@@ -0,0 +1,113 @@
+#include "ThreadCache.h"
+
+SharedAllocator::SharedAllocator(MemoryAllocator &allocator) : _allocator(allocator) {}
+
+MemoryAllocator &SharedAllocator::getAllocator() {
+    return _allocator;
+}
+
+void *SharedAllocator::allocate(size_t size) {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _allocator.allocate(size);
+}
+
+void SharedAllocator::deallocate(void *pointer) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _allocator.deallocate(pointer);
+}
+
+void SharedAllocator::deallocateRemote(void *pointer) {
+    _allocator.deallocateRemote(pointer);
+}
+
+AllocatorStats SharedAllocator::getStats() {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _allocator.getStats();
+}
+
+int SharedAllocator::allocateBatch(int order, void **pointers, int count) {
+    size_t size = _allocator.getOrderSize(order);
+    std::lock_guard<std::mutex> guard(_lock);
+    int allocated = 0;
+    while (allocated < count) {
+        void *pointer = _allocator.allocate(size);
+        if (pointer == nullptr) {
+            break;
+        }
+        pointers[allocated++] = pointer;
+    }
+    return allocated;
+}
+
+void SharedAllocator::deallocateBatch(void **pointers, int count) {
+    std::lock_guard<std::mutex> guard(_lock);
+    for (int i = 0; i < count; i++) {
+        _allocator.deallocate(pointers[i]);
+    }
+}
+
+ThreadCache::ThreadCache(SharedAllocator &shared) : _shared(shared) {
+    for (auto &magazine : _magazines) {
+        magazine.count = 0;
+    }
+}
+
+ThreadCache::~ThreadCache() {
+    flush();
+}
+
+void ThreadCache::refill(int order) {
+    Magazine &magazine = _magazines[order];
+    magazine.count += _shared.allocateBatch(order, magazine.blocks + magazine.count, MAGAZINE_SIZE / 2);
+}
+
+void ThreadCache::drain(int order, int count) {
+    // hand back the oldest blocks, keep the most recently freed (hot) ones
+    Magazine &magazine = _magazines[order];
+    _shared.deallocateBatch(magazine.blocks, count);
+    for (int i = count; i < magazine.count; i++) {
+        magazine.blocks[i - count] = magazine.blocks[i];
+    }
+    magazine.count -= count;
+}
+
+void *ThreadCache::allocate(size_t size) {
+    int order = _shared.getAllocator().getOrder(size);
+    if (order >= CACHED_ORDERS) {
+        return _shared.allocate(size);
+    }
+
+    Magazine &magazine = _magazines[order];
+    if (magazine.count == 0) {
+        refill(order);
+        if (magazine.count == 0) {
+            return nullptr;
+        }
+    }
+    return magazine.blocks[--magazine.count];
+}
+
+void ThreadCache::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    int order = _shared.getAllocator().getBlockOrder(pointer);
+    if (order >= CACHED_ORDERS) {
+        _shared.deallocate(pointer);
+        return;
+    }
+
+    Magazine &magazine = _magazines[order];
+    if (magazine.count == MAGAZINE_SIZE) {
+        drain(order, MAGAZINE_SIZE / 2);
+    }
+    magazine.blocks[magazine.count++] = pointer;
+}
+
+void ThreadCache::flush() {
+    for (int order = 0; order < CACHED_ORDERS; order++) {
+        if (_magazines[order].count > 0) {
+            drain(order, _magazines[order].count);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef BUDDY_ALLOCATION_THREADCACHE_H
+#define BUDDY_ALLOCATION_THREADCACHE_H
+
+
+#include <mutex>
+#include "MemoryAllocator.h"
+
+#define MAGAZINE_SIZE 64
+#define CACHED_ORDERS 8
+
+// MemoryAllocator guarded by a single mutex, shared by all threads.
+// Batch calls move a whole magazine under one lock acquisition.
+class SharedAllocator {
+private:
+    MemoryAllocator &_allocator;
+    std::mutex _lock;
+
+public:
+    explicit SharedAllocator(MemoryAllocator &allocator);
+
+    MemoryAllocator &getAllocator();
+
+    void *allocate(size_t size);
+    void deallocate(void *pointer);
+    // Queues the block for the next allocate() without taking the lock.
+    void deallocateRemote(void *pointer);
+    AllocatorStats getStats();
+
+    int allocateBatch(int order, void **pointers, int count);
+    void deallocateBatch(void **pointers, int count);
+};
+
+struct Magazine {
+    int count;
+    void *blocks[MAGAZINE_SIZE];
+};
+
+// Per-thread cache of recently freed blocks, one magazine per order.
+// Create one per thread (e.g. thread_local); blocks are returned to
+// the shared allocator in batches and on destruction.
+class ThreadCache {
+private:
+    SharedAllocator &_shared;
+    Magazine _magazines[CACHED_ORDERS];
+
+    void refill(int order);
+    void drain(int order, int count);
+
+public:
+    explicit ThreadCache(SharedAllocator &shared);
+    ThreadCache(const ThreadCache &) = delete;
+    ThreadCache &operator=(const ThreadCache &) = delete;
+    ~ThreadCache();
+
+    void *allocate(size_t size);
+    void deallocate(void *pointer);
+    void flush();
+};
+
+
+#endif //BUDDY_ALLOCATION_THREADCACHE_H
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../MemoryAllocator.h"
+#include "../BuddyAllocator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Cycles per allocate() for a batch of random-size requests,
+// freed in random order between batches so every order gets split
+// and merged. Falls back to nanoseconds when there is no cycle counter.
+// The runtime-configured MemoryAllocator is compared with BuddyAllocator
+// specialized for the same geometry.
+
+#define BATCH_SIZE 256
+#define BATCHES 8192
+#define ARENA_ORDER 26
+#define ARENA_SIZE (1 << ARENA_ORDER)
+
+using namespace std;
+
+static inline unsigned long long readCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+template <typename Allocator>
+double measure(Allocator &allocator) {
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(1, 16 * 1024);
+
+    vector<size_t> requests(BATCH_SIZE);
+    vector<void *> live(BATCH_SIZE);
+
+    unsigned long long total = 0;
+    for (int batch = 0; batch < BATCHES; batch++) {
+        for (auto &size : requests) {
+            size = sizes(random);
+        }
+
+        unsigned long long start = readCounter();
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            live[i] = allocator.allocate(requests[i]);
+        }
+        total += readCounter() - start;
+
+        shuffle(live.begin(), live.end(), random);
+        for (auto pointer : live) {
+            allocator.deallocate(pointer);
+        }
+    }
+    return double(total) / (BATCH_SIZE * BATCHES);
+}
+
+int main() {
+#if defined(__x86_64__) || defined(__i386__)
+    const char *unit = "cycles";
+#else
+    const char *unit = "ns";
+#endif
+
+    MemoryAllocator runtime(ARENA_SIZE, Measure::BYTE);
+    auto *specialized = new BuddyAllocator<6, ARENA_ORDER>();
+
+    cout << fixed << setprecision(1);
+    cout << "MemoryAllocator::allocate: " << measure(runtime) << " " << unit << " per call" << endl;
+    cout << "BuddyAllocator::allocate:  " << measure(*specialized) << " " << unit << " per call" << endl;
+
+    delete specialized;
+    return EXIT_SUCCESS;
+}
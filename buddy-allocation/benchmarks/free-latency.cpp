@@ -0,0 +1,50 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../MemoryAllocator.h"
+
+// Free latency against the number of live blocks.
+// Every round frees a random live block and allocates it back,
+// so heap occupancy stays at `liveCount` while free is timed.
+
+#define ROUNDS 200000
+#define ARENA_SIZE (64 * 1024 * 1024)
+
+using namespace std;
+
+double measureFree(int liveCount) {
+    MemoryAllocator allocator(ARENA_SIZE, Measure::BYTE);
+    mt19937 random(42);
+
+    vector<void *> live;
+    live.reserve(liveCount);
+    for (int i = 0; i < liveCount; i++) {
+        live.push_back(allocator.allocate(1));
+    }
+
+    uniform_int_distribution<int> pick(0, liveCount - 1);
+    chrono::nanoseconds total(0);
+    for (int i = 0; i < ROUNDS; i++) {
+        int position = pick(random);
+        auto start = chrono::steady_clock::now();
+        allocator.deallocate(live[position]);
+        total += chrono::steady_clock::now() - start;
+        live[position] = allocator.allocate(1);
+    }
+
+    for (auto pointer : live) {
+        allocator.deallocate(pointer);
+    }
+    return double(total.count()) / ROUNDS;
+}
+
+int main() {
+    cout << setw(12) << "live blocks" << setw(16) << "ns per free" << endl;
+    for (int liveCount = 1000; liveCount <= 256000; liveCount *= 4) {
+        cout << setw(12) << liveCount << setw(16) << fixed << setprecision(1)
+             << measureFree(liveCount) << endl;
+    }
+    return EXIT_SUCCESS;
+}
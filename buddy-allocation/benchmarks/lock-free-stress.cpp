@@ -0,0 +1,153 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../LockFreeAllocator.h"
+#include "../ThreadCache.h"
+
+// Stress check and A/B throughput of LockFreeAllocator against the
+// mutex-wrapped MemoryAllocator. The check marks every unit of a handed
+// out block in an ownership table and fails if one is handed out twice;
+// blocks are also filled with the owner id and verified before free.
+
+#define OPERATIONS_PER_THREAD 500000
+#define WORKING_SET 128
+#define ARENA_SIZE (64 * 1024 * 1024)
+
+using namespace std;
+
+static atomic<bool> failed(false);
+
+template <typename Allocator>
+class CheckedAllocator {
+private:
+    Allocator &_allocator;
+    char *_memory;
+    atomic<unsigned char> *_owners;
+
+public:
+    CheckedAllocator(Allocator &allocator, char *memory) : _allocator(allocator), _memory(memory) {
+        unsigned long units = ARENA_SIZE / BLOCK_MIN_SIZE;
+        _owners = new atomic<unsigned char>[units];
+        for (unsigned long i = 0; i < units; i++) {
+            _owners[i].store(0);
+        }
+    }
+
+    ~CheckedAllocator() {
+        delete[] _owners;
+    }
+
+    void *allocate(size_t size, unsigned char owner) {
+        auto *pointer = (char *)_allocator.allocate(size);
+        if (pointer == nullptr) {
+            return nullptr;
+        }
+        size_t blockSize = _allocator.getOrderSize(_allocator.getOrder(size));
+        unsigned long first = (pointer - _memory) / BLOCK_MIN_SIZE;
+        for (unsigned long i = first; i < first + blockSize / BLOCK_MIN_SIZE; i++) {
+            if (_owners[i].exchange(owner) != 0) {
+                failed.store(true);
+            }
+        }
+        memset(pointer, owner, size);
+        return pointer;
+    }
+
+    void deallocate(void *pointer, size_t size, unsigned char owner) {
+        if (pointer == nullptr) {
+            return;
+        }
+        for (size_t i = 0; i < size; i++) {
+            if (((unsigned char *)pointer)[i] != owner) {
+                failed.store(true);
+                break;
+            }
+        }
+        size_t blockSize = _allocator.getOrderSize(_allocator.getOrder(size));
+        unsigned long first = ((char *)pointer - _memory) / BLOCK_MIN_SIZE;
+        for (unsigned long i = first; i < first + blockSize / BLOCK_MIN_SIZE; i++) {
+            _owners[i].store(0);
+        }
+        _allocator.deallocate(pointer);
+    }
+};
+
+template <typename Allocator>
+void stress(CheckedAllocator<Allocator> &checked, unsigned char owner) {
+    mt19937 random(owner);
+    uniform_int_distribution<int> sizes(1, 4096);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    void *live[WORKING_SET] = {};
+    size_t liveSizes[WORKING_SET] = {};
+    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+        int position = pick(random);
+        checked.deallocate(live[position], liveSizes[position], owner);
+        liveSizes[position] = sizes(random);
+        live[position] = checked.allocate(liveSizes[position], owner);
+    }
+    for (int position = 0; position < WORKING_SET; position++) {
+        checked.deallocate(live[position], liveSizes[position], owner);
+    }
+}
+
+template <typename Allocator>
+void churn(Allocator &allocator, unsigned int seed) {
+    mt19937 random(seed);
+    uniform_int_distribution<int> sizes(1, 4096);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    void *live[WORKING_SET] = {};
+    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+        int position = pick(random);
+        allocator.deallocate(live[position]);
+        live[position] = allocator.allocate(sizes(random));
+    }
+    for (auto pointer : live) {
+        allocator.deallocate(pointer);
+    }
+}
+
+template <typename Task>
+double run(int threadsCount, Task task) {
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < threadsCount; i++) {
+        threads.emplace_back(task, i + 1);
+    }
+    for (auto &worker : threads) {
+        worker.join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return threadsCount * 2.0 * OPERATIONS_PER_THREAD / elapsed.count() / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = argc > 1 ? stoi(argv[1]) : int(max(1u, thread::hardware_concurrency()));
+
+    LockFreeAllocator lockFree(ARENA_SIZE, Measure::BYTE);
+    MemoryAllocator memory(ARENA_SIZE, Measure::BYTE);
+    SharedAllocator shared(memory);
+
+    CheckedAllocator<LockFreeAllocator> checked(lockFree, lockFree.getMemoryPointer());
+    run(maxThreads, [&checked](int owner) { stress(checked, (unsigned char)owner); });
+    if (failed.load()) {
+        cerr << "Error: a block was handed out twice\n";
+        return EXIT_FAILURE;
+    }
+    cout << "Stress check passed with " << maxThreads << " threads" << endl << endl;
+
+    cout << setw(8) << "threads" << setw(20) << "mutex Mops/s" << setw(20) << "lock-free Mops/s" << endl;
+    for (int threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2) {
+        double locked = run(threadsCount, [&shared](int seed) { churn(shared, seed); });
+        double atomic = run(threadsCount, [&lockFree](int seed) { churn(lockFree, seed); });
+        cout << setw(8) << threadsCount << fixed << setprecision(2)
+             << setw(20) << locked << setw(20) << atomic << endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../ThreadCache.h"
+
+// Producer/consumer pipeline: one thread allocates blocks from an arena
+// and passes them through a ring to a second thread that frees them.
+// The consumer frees either under the arena's lock or through its
+// remote-free queue, which the producer drains on its next allocate().
+// Reported are pipeline throughput and the consumer's free latency.
+
+#define ITEMS 2000000
+#define RING_SIZE 4096
+#define ARENA_SIZE (256 * 1024 * 1024)
+
+using namespace std;
+using namespace std::chrono;
+
+// single-producer single-consumer ring of block pointers
+struct Ring {
+    void *slots[RING_SIZE];
+    atomic<size_t> head{0};
+    atomic<size_t> tail{0};
+
+    void push(void *pointer) {
+        size_t position = tail.load(memory_order_relaxed);
+        while (position - head.load(memory_order_acquire) == RING_SIZE) {
+            this_thread::yield();
+        }
+        slots[position % RING_SIZE] = pointer;
+        tail.store(position + 1, memory_order_release);
+    }
+
+    void *pop() {
+        size_t position = head.load(memory_order_relaxed);
+        while (tail.load(memory_order_acquire) == position) {
+            this_thread::yield();
+        }
+        void *pointer = slots[position % RING_SIZE];
+        head.store(position + 1, memory_order_release);
+        return pointer;
+    }
+};
+
+void run(SharedAllocator &shared, bool remote) {
+    auto ring = new Ring();
+    vector<long> latencies(ITEMS);
+
+    auto start = steady_clock::now();
+    thread producer([&shared, ring]() {
+        mt19937 random(42);
+        uniform_int_distribution<int> sizes(64, 1024);
+        for (int i = 0; i < ITEMS; i++) {
+            void *pointer;
+            while ((pointer = shared.allocate(sizes(random))) == nullptr) {
+                this_thread::yield();
+            }
+            ring->push(pointer);
+        }
+    });
+    thread consumer([&shared, ring, remote, &latencies]() {
+        for (int i = 0; i < ITEMS; i++) {
+            void *pointer = ring->pop();
+            auto begin = steady_clock::now();
+            if (remote) {
+                shared.deallocateRemote(pointer);
+            } else {
+                shared.deallocate(pointer);
+            }
+            latencies[i] = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+        }
+    });
+    producer.join();
+    consumer.join();
+    duration<double> elapsed = steady_clock::now() - start;
+    delete ring;
+
+    sort(latencies.begin(), latencies.end());
+    cout << setw(10) << (remote ? "queued" : "locked")
+         << setw(16) << fixed << setprecision(2) << ITEMS / elapsed.count() / 1e6
+         << setw(12) << latencies[ITEMS / 2]
+         << setw(12) << latencies[ITEMS * 99 / 100]
+         << setw(12) << latencies[ITEMS - 1] << endl;
+}
+
+int main() {
+    MemoryAllocator allocator(ARENA_SIZE, Measure::BYTE);
+    SharedAllocator shared(allocator);
+
+    cout << setw(10) << "free" << setw(16) << "Mitems/s" << setw(12) << "p50 ns"
+         << setw(12) << "p99 ns" << setw(12) << "max ns" << endl;
+    run(shared, false);
+    run(shared, true);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <iomanip>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "../ChunkedAllocator.h"
+
+// Resident set size over a bursty workload: every burst allocates and
+// touches BURST_SIZE bytes, then frees all but a few long-lived blocks.
+// RSS (relative to the start of the run) is sampled at each burst's peak
+// and after its release, for several chunk release policies.
+
+#define BURSTS 12
+#define BURST_SIZE (128 * 1024 * 1024)
+#define SURVIVORS_PERCENT 2
+
+using namespace std;
+
+long residentSize() {
+    long pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+vector<long> run(ChunkPolicy policy) {
+    ChunkedAllocator allocator(CHUNK_DEFAULT_SIZE, policy);
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(64, 64 * 1024);
+    uniform_int_distribution<int> percent(0, 99);
+
+    vector<long> samples;
+    vector<void *> survivors;
+    long baseline = residentSize();
+
+    for (int burst = 0; burst < BURSTS; burst++) {
+        vector<void *> live;
+        for (size_t allocated = 0; allocated < BURST_SIZE;) {
+            size_t size = sizes(random);
+            void *pointer = allocator.allocate(size);
+            memset(pointer, 1, size);
+            live.push_back(pointer);
+            allocated += size;
+        }
+        samples.push_back(residentSize() - baseline);
+
+        for (auto pointer : live) {
+            if (percent(random) < SURVIVORS_PERCENT) {
+                survivors.push_back(pointer);
+            } else {
+                allocator.deallocate(pointer);
+            }
+        }
+        // long-lived blocks eventually die too, a few bursts later
+        if (burst % 4 == 3) {
+            for (auto pointer : survivors) {
+                allocator.deallocate(pointer);
+            }
+            survivors.clear();
+        }
+        samples.push_back(residentSize() - baseline);
+    }
+
+    for (auto pointer : survivors) {
+        allocator.deallocate(pointer);
+    }
+    return samples;
+}
+
+int main() {
+    vector<long> unmap = run(ChunkPolicy{0, false});
+    vector<long> advise = run(ChunkPolicy{4, true});
+    vector<long> keep = run(ChunkPolicy{INT_MAX, false});
+
+    cout << setw(8) << "burst" << setw(8) << "phase"
+         << setw(16) << "unmap MB" << setw(16) << "retain 4 MB" << setw(16) << "keep all MB" << endl;
+    for (size_t i = 0; i < unmap.size(); i++) {
+        cout << setw(8) << i / 2 << setw(8) << (i % 2 == 0 ? "peak" : "free")
+             << setw(16) << unmap[i] / (1024 * 1024)
+             << setw(16) << advise[i] / (1024 * 1024)
+             << setw(16) << keep[i] / (1024 * 1024) << endl;
+    }
+    return EXIT_SUCCESS;
+}
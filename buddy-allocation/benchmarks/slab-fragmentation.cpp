@@ -0,0 +1,81 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../SlabAllocator.h"
+
+// Bytes requested against bytes reserved for a small-object mix
+// (mostly 16-256 bytes), served by the plain buddy allocator and by
+// the slab front end. Objects are churned first so that both reach
+// a steady state, then the live set is measured.
+
+#define LIVE_OBJECTS 200000
+#define CHURN_OPERATIONS 1000000
+#define ARENA_SIZE (256 * 1024 * 1024)
+
+using namespace std;
+
+struct Report {
+    unsigned long requested;
+    unsigned long reserved;
+    double nanoseconds;
+};
+
+template <typename Allocator>
+Report run(Allocator &allocator, MemoryAllocator &memory) {
+    mt19937 random(42);
+    // skewed towards small objects: half of them are at most 48 bytes
+    lognormal_distribution<double> sizes(3.8, 0.8);
+    uniform_int_distribution<int> pick(0, LIVE_OBJECTS - 1);
+    auto nextSize = [&]() {
+        size_t size = size_t(sizes(random));
+        return size < 1 ? 1 : (size > 256 ? 256 : size);
+    };
+
+    vector<void *> live(LIVE_OBJECTS);
+    vector<size_t> liveSizes(LIVE_OBJECTS);
+    for (int i = 0; i < LIVE_OBJECTS; i++) {
+        liveSizes[i] = nextSize();
+        live[i] = allocator.allocate(liveSizes[i]);
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < CHURN_OPERATIONS; i++) {
+        int position = pick(random);
+        allocator.deallocate(live[position]);
+        liveSizes[position] = nextSize();
+        live[position] = allocator.allocate(liveSizes[position]);
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+    Report report{0, memory.getUsedSize(), elapsed.count() / CHURN_OPERATIONS};
+    for (int i = 0; i < LIVE_OBJECTS; i++) {
+        report.requested += liveSizes[i];
+        allocator.deallocate(live[i]);
+    }
+    return report;
+}
+
+void print(const char *name, Report report) {
+    cout << setw(8) << name
+         << setw(16) << report.requested / 1024
+         << setw(16) << report.reserved / 1024
+         << setw(12) << fixed << setprecision(2) << double(report.reserved) / report.requested
+         << setw(18) << setprecision(1) << report.nanoseconds << endl;
+}
+
+int main() {
+    MemoryAllocator buddyMemory(ARENA_SIZE, Measure::BYTE);
+    Report buddy = run(buddyMemory, buddyMemory);
+
+    MemoryAllocator slabMemory(ARENA_SIZE, Measure::BYTE);
+    SlabAllocator slab(slabMemory);
+    Report slabbed = run(slab, slabMemory);
+
+    cout << setw(8) << "" << setw(16) << "requested KB" << setw(16) << "reserved KB"
+         << setw(12) << "overhead" << setw(18) << "ns per free+alloc" << endl;
+    print("buddy", buddy);
+    print("slab", slabbed);
+    return EXIT_SUCCESS;
+}
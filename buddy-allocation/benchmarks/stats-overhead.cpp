@@ -0,0 +1,61 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../MemoryAllocator.h"
+
+// Alloc/free throughput of a random-size churn, best of several rounds.
+// Built twice: buddy_stats_overhead with the counters and
+// buddy_stats_overhead_off with -DNO_ALLOCATOR_STATS; compare the two.
+
+#define ROUNDS 7
+#define OPERATIONS 4000000
+#define WORKING_SET 1024
+#define ARENA_SIZE (64 * 1024 * 1024)
+
+using namespace std;
+
+double measure(MemoryAllocator &allocator) {
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(1, 4096);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    vector<void *> live(WORKING_SET, nullptr);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        int position = pick(random);
+        allocator.deallocate(live[position]);
+        live[position] = allocator.allocate(sizes(random));
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    for (auto pointer : live) {
+        allocator.deallocate(pointer);
+    }
+    return 2.0 * OPERATIONS / elapsed.count() / 1e6;
+}
+
+int main() {
+    MemoryAllocator allocator(ARENA_SIZE, Measure::BYTE);
+
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        best = max(best, measure(allocator));
+    }
+#ifdef NO_ALLOCATOR_STATS
+    cout << "counters off: " << fixed << setprecision(2) << best << " Mops/s" << endl;
+#else
+    cout << "counters on:  " << fixed << setprecision(2) << best << " Mops/s" << endl;
+
+    AllocatorStats stats = allocator.getStats();
+    unsigned long allocations = 0;
+    for (auto count : stats.allocations) {
+        allocations += count;
+    }
+    cout << "allocations " << allocations << ", splits " << stats.splits << ", merges " << stats.merges
+         << ", peak KB " << stats.peakBytesInUse / 1024 << ", largest free KB " << stats.largestFreeBlock / 1024
+         << endl;
+#endif
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../MemoryAllocator.h"
+
+// Counts system allocations made while the allocator is churning.
+// Free lists live inside the free blocks and block orders in a side
+// table, so allocate() and deallocate() never reach the system allocator.
+// The malloc family is replaced to count, which also covers operator
+// new: it allocates through malloc.
+
+#define OPERATIONS 100000
+#define ARENA_SIZE (16 * 1024 * 1024)
+
+using namespace std;
+
+// glibc's own entry points, to forward to
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+static unsigned long allocationsCount = 0;
+
+extern "C" void *malloc(size_t size) {
+    allocationsCount++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+    allocationsCount++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) {
+    allocationsCount++;
+    return __libc_realloc(pointer, size);
+}
+
+int main() {
+    MemoryAllocator allocator(ARENA_SIZE, Measure::BYTE);
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(1, BLOCK_MIN_SIZE * 64);
+
+    vector<void *> live;
+    live.reserve(OPERATIONS);
+
+    unsigned long allocated = 0;
+    unsigned long before = allocationsCount;
+    for (int i = 0; i < OPERATIONS; i++) {
+        if (live.empty() || random() % 2 == 0) {
+            if (void *pointer = allocator.allocate(sizes(random))) {
+                live.push_back(pointer);
+                allocated++;
+            }
+        } else {
+            allocator.deallocate(live.back());
+            live.pop_back();
+        }
+    }
+    for (auto pointer : live) {
+        allocator.deallocate(pointer);
+    }
+    unsigned long bookkeeping = allocationsCount - before;
+
+    cout << "Blocks allocated: " << allocated << endl;
+    cout << "System allocations: " << bookkeeping << endl;
+
+    if (bookkeeping != 0) {
+        cerr << "Error: allocator bookkeeping called the system allocator\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../ThreadCache.h"
+
+// Alloc/free throughput for 1..N threads: every thread churns a small
+// working set of random-size blocks, either straight through the
+// mutex-wrapped SharedAllocator or through its own ThreadCache.
+
+#define OPERATIONS_PER_THREAD 1000000
+#define WORKING_SET 64
+#define ARENA_SIZE (256 * 1024 * 1024)
+
+using namespace std;
+
+template <typename Allocator>
+void churn(Allocator &allocator, unsigned int seed) {
+    mt19937 random(seed);
+    uniform_int_distribution<int> sizes(1, 1024);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    void *live[WORKING_SET] = {};
+    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+        int position = pick(random);
+        allocator.deallocate(live[position]);
+        live[position] = allocator.allocate(sizes(random));
+    }
+    for (auto pointer : live) {
+        allocator.deallocate(pointer);
+    }
+}
+
+double measure(SharedAllocator &shared, int threadsCount, bool cached) {
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < threadsCount; i++) {
+        threads.emplace_back([&shared, cached, i]() {
+            if (cached) {
+                ThreadCache cache(shared);
+                churn(cache, i);
+            } else {
+                churn(shared, i);
+            }
+        });
+    }
+    for (auto &worker : threads) {
+        worker.join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return threadsCount * 2.0 * OPERATIONS_PER_THREAD / elapsed.count() / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    MemoryAllocator allocator(ARENA_SIZE, Measure::BYTE);
+    SharedAllocator shared(allocator);
+
+    int maxThreads = argc > 1 ? stoi(argv[1]) : int(max(1u, thread::hardware_concurrency()));
+
+    cout << setw(8) << "threads" << setw(20) << "mutex Mops/s" << setw(20) << "cached Mops/s" << endl;
+    for (int threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2) {
+        double locked = measure(shared, threadsCount, false);
+        double cached = measure(shared, threadsCount, true);
+        cout << setw(8) << threadsCount << fixed << setprecision(2)
+             << setw(20) << locked << setw(20) << cached << endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -19,7 +19,7 @@ int main(int argc, char* argv[]) {
 
     srandom(time(nullptr));
 
-    auto _ = MemoryAllocator(memorySize, Measure::K_BYTE);
+    MemoryAllocator _(memorySize, Measure::K_BYTE);
 
     cout << "Memory initialized with next parameters\n";
     cout << "---------------------------------------\n";
@@ -38,13 +38,20 @@ int main(int argc, char* argv[]) {
         int size = randomNumber(64, 256);
         cout << "Allocation of " << size << " KB" << endl;
         block = _.alloc(size);
-        cout << "Address of allocation result: " << block->startAddress << endl;
+        if (block == nullptr) {
+            cout << "Allocation failed: not enough memory" << endl << endl;
+            continue;
+        }
+        cout << "Address of allocation result: " << (void *)(block->startAddress) << endl;
         cout << "Free memory structure: " << endl;
         _.dump();
         cout << endl;
     }
 
     for (int i = ALLOCATIONS_COUNT - 1 ; i >= 0; i--) {
+        if (blocks[i] == nullptr) {
+            continue;
+        }
         cout << "Free of " << blocks[i]->size << " KB" << endl;
         _.free(blocks[i]);
         cout << "Free memory structure: " << endl;
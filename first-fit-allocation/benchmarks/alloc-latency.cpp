@@ -0,0 +1,46 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// mem_alloc latency against heap population. The heap is grown in steps
+// with used blocks separated by small free holes that never fit the
+// measured requests; at each step random-size alloc/free pairs are timed.
+
+#define ROUNDS 100000
+#define HOLE_SIZE 16
+
+using namespace std;
+
+int main() {
+    init_heap();
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(HOLE_SIZE + 1, 256);
+
+    cout << setw(14) << "heap blocks" << setw(20) << "ns per alloc+free" << endl;
+
+    int blocksCount = 0;
+    for (int target = 1000; target <= 64000; target *= 4) {
+        // used, hole, used, hole, ...
+        while (blocksCount < target) {
+            mem_alloc(HOLE_SIZE);
+            auto hole = mem_alloc(HOLE_SIZE);
+            mem_alloc(HOLE_SIZE);
+            mem_free(hole);
+            blocksCount += 3;
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            mem_free(mem_alloc(sizes(random)));
+        }
+        chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+        cout << setw(14) << blocksCount << setw(20) << fixed << setprecision(1)
+             << elapsed.count() / ROUNDS << endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Zero-initialized buffers through mem_calloc against mem_alloc plus
+// memset, on memory fresh from the break, on large mapped blocks and on
+// heap space that mem_free handed back with MADV_DONTNEED. Only the
+// allocation is timed; the buffers are not touched afterwards, so the
+// page faults counted are the ones the zeroing itself caused.
+// Each case runs in a forked child so that it starts from a fresh heap.
+
+#define TOTAL_SIZE (size_t(256) << 20)
+
+using namespace std;
+
+long pageFaults() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+word_t * allocate(bool calloc, size_t size) {
+    if (calloc) {
+        return mem_calloc(1, size);
+    }
+    auto data = mem_alloc(size);
+    memset(data, 0, size);
+    return data;
+}
+
+void run(bool calloc, size_t size, bool reuse) {
+    init_heap();
+    mem_alloc(8);
+    auto count = TOTAL_SIZE / size;
+    vector<word_t *> buffers(count);
+
+    if (reuse) {
+        // fill the heap and free all but a fence block at its top,
+        // so the space stays in the heap and is purged, not trimmed
+        for (auto &buffer : buffers) {
+            buffer = mem_alloc(size);
+            memset(buffer, 1, size);
+        }
+        mem_alloc(8);
+        for (auto buffer : buffers) {
+            mem_free(buffer);
+        }
+    }
+
+    auto faults = pageFaults();
+    auto start = chrono::steady_clock::now();
+    for (auto &buffer : buffers) {
+        buffer = allocate(calloc, size);
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    cout << setw(14) << (reuse ? "purged heap" : size >= MMAP_THRESHOLD ? "mapped" : "fresh break")
+         << setw(10) << size / 1024
+         << setw(16) << (calloc ? "mem_calloc" : "alloc+memset")
+         << setw(10) << fixed << setprecision(1) << elapsed.count() * 1000
+         << setw(14) << pageFaults() - faults << endl;
+}
+
+void runForked(bool calloc, size_t size, bool reuse) {
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        run(calloc, size, reuse);
+        cout.flush();
+        _exit(EXIT_SUCCESS);
+    }
+    waitpid(child, nullptr, 0);
+}
+
+int main() {
+    cout << setw(14) << "memory" << setw(10) << "KB" << setw(16) << "allocation"
+         << setw(10) << "ms" << setw(14) << "page faults" << endl;
+    for (auto reuse : {false, true}) {
+        for (size_t size : {size_t(16) << 10, size_t(1) << 20}) {
+            if (reuse && size >= MMAP_THRESHOLD) {
+                continue;
+            }
+            runForked(false, size, reuse);
+            runForked(true, size, reuse);
+        }
+    }
+    return EXIT_SUCCESS;
+}
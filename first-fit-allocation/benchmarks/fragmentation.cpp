@@ -0,0 +1,56 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Long-running fragmentation check: objects with random sizes and random
+// lifetimes are allocated and freed for many steps while the live set
+// stays roughly constant. Heap size (the break) and the largest free
+// block are reported as the run goes.
+
+#define STEPS 2000000
+#define REPORT_EVERY 200000
+#define LIVE_OBJECTS 4000
+
+using namespace std;
+
+int main() {
+    init_heap();
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(8, 512);
+    uniform_int_distribution<int> pick(0, LIVE_OBJECTS - 1);
+
+    auto heapBegin = mem_get_heap()->space.brk;
+    auto first = mem_alloc(8);
+    auto firstBlock = get_mem_block(first);
+
+    vector<word_t *> live(LIVE_OBJECTS, nullptr);
+
+    cout << setw(10) << "step" << setw(16) << "heap KB" << setw(20) << "largest free B" << endl;
+    for (int step = 1; step <= STEPS; step++) {
+        int position = pick(random);
+        if (live[position] != nullptr) {
+            mem_free(live[position]);
+        }
+        live[position] = mem_alloc(sizes(random));
+        if (live[position] == nullptr) {
+            cerr << "Error: heap exhausted at step " << step << endl;
+            return EXIT_FAILURE;
+        }
+
+        if (step % REPORT_EVERY == 0) {
+            size_t largest = 0;
+            for (auto block = firstBlock; block != nullptr; block = get_next(block)) {
+                if (!is_used(block) && get_size(block) > largest) {
+                    largest = get_size(block);
+                }
+            }
+            cout << setw(10) << step << setw(16) << (mem_get_heap()->space.brk - heapBegin) / 1024
+                 << setw(20) << largest << endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
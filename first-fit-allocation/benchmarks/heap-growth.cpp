@@ -0,0 +1,85 @@
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Heap growth far past the old fixed 4 MB heap: a live set of
+// argv[1] MB (default 1024) is built from touched blocks of random size,
+// then freed from the top down in steps. Live bytes, the break, the
+// committed part of the reservation and resident size are reported
+// after every step.
+
+#define DEFAULT_LIVE_MB 1024
+#define STEPS 8
+
+using namespace std;
+
+long residentSize() {
+    long pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void report(const char *phase, size_t liveBytes, char *heapBegin, long baseline) {
+    cout << setw(10) << phase
+         << setw(12) << liveBytes / (1024 * 1024)
+         << setw(12) << (mem_get_heap()->space.brk - heapBegin) / (1024 * 1024)
+         << setw(14) << (mem_get_heap()->space.commit - mem_get_heap()->space.begin) / (1024 * 1024)
+         << setw(10) << (residentSize() - baseline) / (1024 * 1024) << endl;
+}
+
+int main(int argc, char const *argv[]) {
+    size_t liveTarget = size_t(argc > 1 ? atoi(argv[1]) : DEFAULT_LIVE_MB) * 1024 * 1024;
+
+    init_heap();
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(64, 64 * 1024);
+
+    auto heapBegin = mem_get_heap()->space.brk;
+    long baseline = residentSize();
+
+    cout << setw(10) << "phase" << setw(12) << "live MB" << setw(12) << "break MB"
+         << setw(14) << "committed MB" << setw(10) << "RSS MB" << endl;
+
+    vector<word_t *> live;
+    vector<size_t> liveSizes;
+    size_t liveBytes = 0;
+    while (liveBytes < liveTarget) {
+        size_t size = sizes(random);
+        auto data = mem_alloc(size);
+        if (data == nullptr) {
+            cerr << "Error: heap exhausted at " << liveBytes / (1024 * 1024) << " MB" << endl;
+            return EXIT_FAILURE;
+        }
+        memset(data, 1, size);
+        live.push_back(data);
+        liveSizes.push_back(size);
+        liveBytes += size;
+    }
+    report("grown", liveBytes, heapBegin, baseline);
+
+    // freeing from the top coalesces into the trailing block,
+    // which mem_free hands back once it crosses the trim threshold
+    size_t stepSize = live.size() / STEPS + 1;
+    while (!live.empty()) {
+        for (size_t i = 0; i < stepSize && !live.empty(); i++) {
+            mem_free(live.back());
+            liveBytes -= liveSizes.back();
+            live.pop_back();
+            liveSizes.pop_back();
+        }
+        report("freed", liveBytes, heapBegin, baseline);
+    }
+
+    mem_trim();
+    report("trimmed", liveBytes, heapBegin, baseline);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "memory-block.h"
+#include "memory-allocation.h"
+#include "profile.h"
+
+// Three call sites keep known amounts of memory live while a fourth
+// churns; the profile should attribute the live bytes to the first three.
+// Also compares churn throughput with sampling off and on at the default
+// interval. Built with -DHEAP_PROFILE only.
+
+#define SAMPLE_INTERVAL (64 * 1024)
+#define ROUNDS 5
+#define OPERATIONS 4000000
+#define WORKING_SET 1024
+
+using namespace std;
+
+__attribute__((noinline)) void keep_small(vector<word_t *> &live) {
+    for (int i = 0; i < 200000; i++) {
+        live.push_back(mem_alloc(64));
+    }
+}
+
+__attribute__((noinline)) void keep_medium(vector<word_t *> &live) {
+    for (int i = 0; i < 20000; i++) {
+        live.push_back(mem_alloc(1000));
+    }
+}
+
+__attribute__((noinline)) void keep_large(vector<word_t *> &live) {
+    for (int i = 0; i < 40; i++) {
+        live.push_back(mem_alloc(256 * 1024));
+    }
+}
+
+__attribute__((noinline)) double churn() {
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(1, 4096);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    vector<word_t *> live(WORKING_SET, nullptr);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        auto &data = live[pick(random)];
+        if (data != nullptr) {
+            mem_free(data);
+        }
+        data = mem_alloc(sizes(random));
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    for (auto data : live) {
+        if (data != nullptr) {
+            mem_free(data);
+        }
+    }
+    return 2.0 * OPERATIONS / elapsed.count() / 1e6;
+}
+
+double best_churn() {
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        best = max(best, churn());
+    }
+    return best;
+}
+
+int main() {
+    init_heap();
+
+    cout << "sampling off: " << fixed << setprecision(2) << best_churn() << " Mops/s" << endl;
+    heap_profile_start();
+    cout << "sampling on:  " << fixed << setprecision(2) << best_churn() << " Mops/s" << endl;
+
+    // a denser profile for the accuracy check
+    heap_profile_start(SAMPLE_INTERVAL);
+    vector<word_t *> live;
+    keep_small(live);
+    keep_medium(live);
+    keep_large(live);
+    churn();
+
+    size_t actual = 200000 * 64 + 20000 * 1000 + 40 * 256 * 1024;
+    size_t estimated = heap_profile_live_bytes();
+    cout << "live KB " << actual / 1024 << ", estimated KB " << estimated / 1024 << " ("
+         << showpos << setprecision(1) << 100.0 * (double(estimated) - double(actual)) / double(actual) << noshowpos
+         << "%)" << endl << endl;
+    cout.flush();
+    heap_profile_dump(STDOUT_FILENO);
+
+    for (auto data : live) {
+        mem_free(data);
+    }
+    cout << endl << "after freeing, estimated KB " << heap_profile_live_bytes() / 1024 << endl;
+    return EXIT_SUCCESS;
+}
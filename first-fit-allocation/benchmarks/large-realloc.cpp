@@ -0,0 +1,68 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// A buffer grows from 1 MB to 1 GB by a fixed factor, writing its new
+// tail after every step. mem_realloc remaps the pages of the large block,
+// and is compared with moving it by hand (allocate, copy, free) as a
+// heap without the mapped path would have to.
+
+#define START_SIZE (size_t(1) << 20)
+#define END_SIZE (size_t(1) << 30)
+
+using namespace std;
+using namespace std::chrono;
+
+size_t copiedBytes = 0;
+
+word_t * realloc_by_copy(word_t *data, size_t oldSize, size_t size) {
+    auto resData = mem_alloc(size);
+    memcpy(resData, data, oldSize);
+    copiedBytes += oldSize;
+    mem_free(data);
+    return resData;
+}
+
+template <bool Remap>
+void run(const char *name, double factor) {
+    copiedBytes = 0;
+    int steps = 0;
+    auto begin = steady_clock::now();
+
+    size_t size = START_SIZE;
+    auto data = mem_alloc(size);
+    memset(data, 1, size);
+    while (size < END_SIZE) {
+        auto newSize = min(END_SIZE, size_t(size * factor));
+        data = Remap ? mem_realloc(data, newSize) : realloc_by_copy(data, size, newSize);
+        if (data == nullptr) {
+            cerr << "Error: out of memory at " << newSize / (1024 * 1024) << " MB" << endl;
+            exit(EXIT_FAILURE);
+        }
+        memset((char *)data + size, 1, newSize - size);
+        size = newSize;
+        steps++;
+    }
+    mem_free(data);
+
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - begin).count();
+    cout << setw(10) << name << setw(10) << factor << setw(8) << steps
+         << setw(12) << elapsed << setw(14) << copiedBytes / (1024 * 1024) << endl;
+}
+
+int main() {
+    init_heap();
+
+    cout << setw(10) << "realloc" << setw(10) << "factor" << setw(8) << "steps"
+         << setw(12) << "ms" << setw(14) << "copied MB" << endl;
+    for (double factor : {2.0, 1.25}) {
+        run<true>("mremap", factor);
+        run<false>("copy", factor);
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Runs the same random workload under every placement policy and reports
+// throughput, final heap size and external fragmentation
+// (1 - largest free block / all free bytes). Each policy runs in a forked
+// child so that it starts from a fresh heap.
+
+#define OPERATIONS 2000000
+#define LIVE_OBJECTS 4000
+
+using namespace std;
+
+template <typename Policy>
+void run(const char *name) {
+    init_heap();
+    mt19937 random(42);
+    // mostly small objects with an occasional large one
+    uniform_int_distribution<int> small(8, 256);
+    uniform_int_distribution<int> large(1024, 8192);
+    uniform_int_distribution<int> percent(0, 99);
+    uniform_int_distribution<int> pick(0, LIVE_OBJECTS - 1);
+
+    auto heapBegin = mem_get_heap()->space.brk;
+    auto firstBlock = get_mem_block(mem_alloc_with<Policy>(8));
+    vector<word_t *> live(LIVE_OBJECTS, nullptr);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        int position = pick(random);
+        if (live[position] != nullptr) {
+            mem_free(live[position]);
+        }
+        size_t size = percent(random) < 5 ? large(random) : small(random);
+        live[position] = mem_alloc_with<Policy>(size);
+        if (live[position] == nullptr) {
+            cout << setw(10) << name << "  heap exhausted after " << i << " operations" << endl;
+            return;
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    size_t freeBytes = 0, largest = 0;
+    for (auto block = firstBlock; block != nullptr; block = get_next(block)) {
+        if (!is_used(block)) {
+            freeBytes += get_size(block);
+            largest = max(largest, get_size(block));
+        }
+    }
+
+    cout << setw(10) << name
+         << setw(16) << fixed << setprecision(2) << 2.0 * OPERATIONS / elapsed.count() / 1e6
+         << setw(12) << (mem_get_heap()->space.brk - heapBegin) / 1024
+         << setw(16) << setprecision(3) << (freeBytes == 0 ? 0.0 : 1.0 - double(largest) / freeBytes)
+         << endl;
+}
+
+template <typename Policy>
+void runForked(const char *name) {
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) {
+        run<Policy>(name);
+        cout.flush();
+        _exit(EXIT_SUCCESS);
+    }
+    waitpid(child, nullptr, 0);
+}
+
+int main() {
+    cout << setw(10) << "policy" << setw(16) << "Mops/s" << setw(12) << "heap KB"
+         << setw(16) << "fragmentation" << endl;
+    runForked<FirstFit>("first-fit");
+    runForked<NextFit>("next-fit");
+    runForked<BestFit>("best-fit");
+    runForked<GoodFit>("good-fit");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Vector-style growth: buffers grow by a constant factor through
+// mem_realloc, writing their new tail after every step. Every realloc is
+// classified as done in place (same address), remapped (a mapped block,
+// moved by the kernel) or copied. A copy is either a move into a free
+// predecessor or a move to a new block; both copy the live payload once.
+
+using namespace std;
+using namespace std::chrono;
+
+struct Counts {
+    long inPlace = 0;
+    long remapped = 0;
+    long copied = 0;
+};
+
+word_t * grow(word_t *data, size_t oldSize, size_t size, Counts &counts) {
+    auto wasMapped = is_mapped(get_mem_block(data));
+    auto resData = mem_realloc(data, size);
+    if (resData == data) {
+        counts.inPlace++;
+    } else if (wasMapped && size >= MMAP_THRESHOLD) {
+        counts.remapped++;
+    } else {
+        counts.copied++;
+    }
+    memset((char *)resData + oldSize, 1, size - oldSize);
+    return resData;
+}
+
+void report(const char *name, Counts counts, long elapsed) {
+    auto total = counts.inPlace + counts.remapped + counts.copied;
+    cout << setw(24) << name << setw(10) << total << setw(10) << counts.inPlace
+         << setw(10) << counts.remapped << setw(10) << counts.copied
+         << setw(12) << fixed << setprecision(1) << 100.0 * (total - counts.copied) / total
+         << setw(10) << elapsed << endl;
+}
+
+// one buffer alone at the top of the heap, 8 B to 64 MB
+void single(double factor) {
+    Counts counts;
+    auto begin = steady_clock::now();
+
+    size_t size = 8;
+    auto data = mem_alloc(size);
+    while (size < (size_t(64) << 20)) {
+        auto newSize = (size_t(size * factor) + 8) & ~size_t(7);
+        data = grow(data, size, newSize, counts);
+        size = newSize;
+    }
+    mem_free(data);
+
+    report(factor == 2 ? "single, x2" : "single, x1.5", counts,
+           duration_cast<milliseconds>(steady_clock::now() - begin).count());
+}
+
+// many buffers growing in turns, so their neighbours are mostly in use,
+// while some of them are dropped and started again
+void interleaved(int buffers, size_t maxSize, double factor, int dropPercent) {
+    Counts counts;
+    mt19937 random(42);
+    uniform_int_distribution<int> percent(0, 99);
+    auto begin = steady_clock::now();
+
+    vector<word_t *> data(buffers);
+    vector<size_t> sizes(buffers, 8);
+    for (int i = 0; i < buffers; i++) {
+        data[i] = mem_alloc(sizes[i]);
+    }
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < buffers; i++) {
+            if (sizes[i] >= maxSize || percent(random) < dropPercent) {
+                mem_free(data[i]);
+                sizes[i] = 8;
+                data[i] = mem_alloc(sizes[i]);
+                continue;
+            }
+            auto newSize = (size_t(sizes[i] * factor) + 8) & ~size_t(7);
+            data[i] = grow(data[i], sizes[i], newSize, counts);
+            sizes[i] = newSize;
+        }
+    }
+    for (auto pointer : data) {
+        mem_free(pointer);
+    }
+
+    auto name = "x" + to_string(buffers) + (dropPercent ? ", churn" : "") + (factor == 2 ? ", x2" : ", x1.5");
+    report(name.c_str(), counts, duration_cast<milliseconds>(steady_clock::now() - begin).count());
+}
+
+int main() {
+    init_heap();
+    // a first block that is never freed, as in a long-running program
+    mem_alloc(8);
+
+    cout << setw(24) << "workload" << setw(10) << "reallocs" << setw(10) << "in place"
+         << setw(10) << "remapped" << setw(10) << "copied" << setw(12) << "no copy %"
+         << setw(10) << "ms" << endl;
+    single(2);
+    single(1.5);
+    interleaved(64, 64 * 1024, 2, 0);
+    interleaved(64, 64 * 1024, 1.5, 0);
+    interleaved(256, 16 * 1024, 1.5, 10);
+    interleaved(1024, 4 * 1024, 1.5, 20);
+
+    return 0;
+}
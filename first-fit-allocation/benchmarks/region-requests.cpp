@@ -0,0 +1,109 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "sbrk.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+#include "region.h"
+
+// Request-scoped workload: every request allocates a few hundred small
+// objects, some of them in a nested scratch phase, and drops them all
+// when it ends. Compared are mem_alloc/mem_free of every object and a
+// region that is reset after each request, with the scratch phase
+// rolled back to a savepoint.
+
+#define REQUESTS 200000
+#define MIN_OBJECTS 100
+#define MAX_OBJECTS 500
+
+using namespace std;
+using namespace std::chrono;
+
+struct Request {
+    int objects;
+    int scratchObjects;
+    vector<size_t> sizes;
+};
+
+vector<Request> makeRequests() {
+    mt19937 random(42);
+    uniform_int_distribution<int> objects(MIN_OBJECTS, MAX_OBJECTS);
+    uniform_int_distribution<int> sizes(16, 256);
+
+    vector<Request> requests(REQUESTS);
+    for (auto &request : requests) {
+        request.objects = objects(random);
+        request.scratchObjects = request.objects / 4;
+        for (int i = 0; i < request.objects + request.scratchObjects; i++) {
+            request.sizes.push_back(sizes(random));
+        }
+    }
+    return requests;
+}
+
+void report(const char *name, const vector<Request> &requests, duration<double> elapsed) {
+    long objects = 0;
+    for (auto &request : requests) {
+        objects += request.objects + request.scratchObjects;
+    }
+    cout << setw(14) << name
+         << setw(14) << fixed << setprecision(0) << requests.size() / elapsed.count()
+         << setw(14) << setprecision(1) << elapsed.count() * 1e9 / objects << endl;
+}
+
+void runHeap(const vector<Request> &requests) {
+    vector<word_t *> live, scratch;
+    auto start = steady_clock::now();
+    for (auto &request : requests) {
+        int i = 0;
+        for (; i < request.objects; i++) {
+            live.push_back(mem_alloc(request.sizes[i]));
+            live.back()[0] = i;
+        }
+        for (; i < request.objects + request.scratchObjects; i++) {
+            scratch.push_back(mem_alloc(request.sizes[i]));
+            scratch.back()[0] = i;
+        }
+        for (auto data : scratch) {
+            mem_free(data);
+        }
+        for (auto data : live) {
+            mem_free(data);
+        }
+        live.clear();
+        scratch.clear();
+    }
+    report("mem_alloc", requests, steady_clock::now() - start);
+}
+
+void runRegion(const vector<Request> &requests) {
+    auto region = region_create();
+    auto start = steady_clock::now();
+    for (auto &request : requests) {
+        int i = 0;
+        for (; i < request.objects; i++) {
+            region_alloc(region, request.sizes[i])[0] = i;
+        }
+        auto mark = region_save(region);
+        for (; i < request.objects + request.scratchObjects; i++) {
+            region_alloc(region, request.sizes[i])[0] = i;
+        }
+        region_restore(region, mark);
+        region_reset(region);
+    }
+    report("region", requests, steady_clock::now() - start);
+    region_destroy(region);
+}
+
+int main() {
+    init_heap();
+    auto requests = makeRequests();
+
+    cout << setw(14) << "allocator" << setw(14) << "requests/s" << setw(14) << "ns/object" << endl;
+    runHeap(requests);
+    runRegion(requests);
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Alloc/free throughput of a random-size churn, best of several rounds.
+// Built twice: first_fit_stats_overhead with the counters and
+// first_fit_stats_overhead_off with -DNO_ALLOCATOR_STATS; compare the two.
+
+#define ROUNDS 7
+#define OPERATIONS 4000000
+#define WORKING_SET 1024
+
+using namespace std;
+
+double measure() {
+    mt19937 random(42);
+    uniform_int_distribution<int> sizes(1, 4096);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    vector<word_t *> live(WORKING_SET, nullptr);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        auto &data = live[pick(random)];
+        if (data != nullptr) {
+            mem_free(data);
+        }
+        data = mem_alloc(sizes(random));
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    for (auto data : live) {
+        if (data != nullptr) {
+            mem_free(data);
+        }
+    }
+    return 2.0 * OPERATIONS / elapsed.count() / 1e6;
+}
+
+int main() {
+    init_heap();
+
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        best = max(best, measure());
+    }
+#ifdef NO_ALLOCATOR_STATS
+    cout << "counters off: " << fixed << setprecision(2) << best << " Mops/s" << endl;
+#else
+    cout << "counters on:  " << fixed << setprecision(2) << best << " Mops/s" << endl;
+
+    auto stats = mem_get_stats();
+    size_t allocations = 0;
+    for (auto count : stats.allocations) {
+        allocations += count;
+    }
+    cout << "allocations " << allocations << ", splits " << stats.splits << ", coalesces " << stats.coalesces
+         << ", peak KB " << stats.peakBytesInUse / 1024 << ", reserved KB " << stats.bytesReserved / 1024
+         << ", largest free KB " << stats.largestFreeBlock / 1024 << endl;
+#endif
+    return EXIT_SUCCESS;
+}
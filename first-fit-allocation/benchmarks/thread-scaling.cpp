@@ -0,0 +1,103 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// Alloc/free throughput for 1..N threads (argv[1], default: all CPUs).
+// Every thread churns a small working set of random-size blocks, and
+// hands every REMOTE_EVERY-th block to the next thread, which frees it.
+// Compared are one heap shared by all threads and a heap per thread
+// (mem_alloc), where only the handed-over blocks cross heaps.
+
+#define OPERATIONS_PER_THREAD 1000000
+#define WORKING_SET 64
+#define REMOTE_EVERY 16
+
+using namespace std;
+
+struct Mailbox {
+    mutex lock;
+    vector<word_t *> blocks;
+};
+
+void churn(Heap *shared, vector<Mailbox> &mailboxes, int index) {
+    mt19937 random(index);
+    uniform_int_distribution<int> sizes(1, 1024);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+    auto &next = mailboxes[(index + 1) % mailboxes.size()];
+    auto &own = mailboxes[index];
+    vector<word_t *> received;
+
+    word_t *live[WORKING_SET] = {};
+    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+        int position = pick(random);
+        if (live[position] != nullptr) {
+            if (i % REMOTE_EVERY == 0) {
+                lock_guard<mutex> guard(next.lock);
+                next.blocks.push_back(live[position]);
+            } else {
+                mem_free(live[position]);
+            }
+        }
+        live[position] = shared != nullptr ? heap_alloc(shared, sizes(random)) : mem_alloc(sizes(random));
+
+        if (i % 256 == 0) {
+            {
+                lock_guard<mutex> guard(own.lock);
+                received.swap(own.blocks);
+            }
+            for (auto data : received) {
+                mem_free(data);
+            }
+            received.clear();
+        }
+    }
+    for (auto data : live) {
+        if (data != nullptr) {
+            mem_free(data);
+        }
+    }
+}
+
+double measure(Heap *shared, int threadsCount) {
+    vector<Mailbox> mailboxes(threadsCount);
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < threadsCount; i++) {
+        threads.emplace_back([shared, &mailboxes, i]() {
+            churn(shared, mailboxes, i);
+        });
+    }
+    for (auto &worker : threads) {
+        worker.join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    // blocks still in flight when their receiver had finished
+    for (auto &mailbox : mailboxes) {
+        for (auto data : mailbox.blocks) {
+            mem_free(data);
+        }
+    }
+    return threadsCount * 2.0 * OPERATIONS_PER_THREAD / elapsed.count() / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    auto shared = heap_create();
+    int maxThreads = argc > 1 ? stoi(argv[1]) : int(max(1u, thread::hardware_concurrency()));
+
+    cout << setw(8) << "threads" << setw(20) << "shared Mops/s" << setw(20) << "per-thread Mops/s" << endl;
+    for (int threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2) {
+        double sharedRate = measure(shared, threadsCount);
+        double ownRate = measure(nullptr, threadsCount);
+        cout << setw(8) << threadsCount << fixed << setprecision(2)
+             << setw(20) << sharedRate << setw(20) << ownRate << endl;
+    }
+    heap_destroy(shared);
+    return EXIT_SUCCESS;
+}
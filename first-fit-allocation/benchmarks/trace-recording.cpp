@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "memory-block.h"
+#include "memory-allocation.h"
+#include "trace.h"
+
+// Cost of recording: the same multi-threaded alloc/realloc/free churn
+// runs with no trace open and while recording into a trace file, which
+// is kept for replay:
+//
+//   first_fit_trace_recording [PATH]
+//   allocator_benchmarks --trace PATH
+
+#define THREADS 4
+#define OPERATIONS_PER_THREAD 1000000
+#define WORKING_SET 1024
+
+using namespace std;
+
+void churn(unsigned int seed) {
+    mt19937 random(seed);
+    uniform_int_distribution<int> sizes(8, 2048);
+    uniform_int_distribution<int> percent(0, 99);
+    uniform_int_distribution<int> pick(0, WORKING_SET - 1);
+
+    vector<word_t *> live(WORKING_SET, nullptr);
+    for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+        auto &data = live[pick(random)];
+        if (data != nullptr && percent(random) < 20) {
+            data = mem_realloc(data, sizes(random));
+        } else {
+            if (data != nullptr) {
+                mem_free(data);
+            }
+            data = mem_alloc(sizes(random));
+        }
+    }
+    for (auto data : live) {
+        if (data != nullptr) {
+            mem_free(data);
+        }
+    }
+}
+
+double measure() {
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < THREADS; i++) {
+        threads.emplace_back(churn, i);
+    }
+    for (auto &worker : threads) {
+        worker.join();
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (THREADS * 2.0 * OPERATIONS_PER_THREAD);
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "first-fit.trace";
+
+    measure();
+    double untraced = measure();
+    if (!trace_open(path)) {
+        cerr << "Error: cannot create " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    double traced = measure();
+    trace_close();
+
+    cout << setw(12) << "tracing" << setw(12) << "ns per op" << endl;
+    cout << setw(12) << "off" << setw(12) << fixed << setprecision(1) << untraced << endl;
+    cout << setw(12) << "on" << setw(12) << traced << endl;
+    cout << "trace written to " << path << endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include "free-list.h"
+
+size_t get_size_class(size_t size) {
+    if (size < SMALL_SIZE_LIMIT) {
+        return size / sizeof(word_t);
+    }
+    // [2^k, 2^(k+1)) bytes are split into SECOND_LEVEL_COUNT classes
+    size_t log = 63 - __builtin_clzl(size);
+    size_t firstLevel = log - (SECOND_LEVEL_SHIFT + 3) + 1;
+    size_t secondLevel = (size >> (log - SECOND_LEVEL_SHIFT)) & (SECOND_LEVEL_COUNT - 1);
+    return firstLevel * SECOND_LEVEL_COUNT + secondLevel;
+}
+
+size_t get_fit_class(size_t size) {
+    if (size >= SMALL_SIZE_LIMIT) {
+        // round up to the next class bound
+        size_t log = 63 - __builtin_clzl(size);
+        size += (size_t(1) << (log - SECOND_LEVEL_SHIFT)) - 1;
+    }
+    return get_size_class(size);
+}
+
+// first nonempty class at or above the given one, or FREE_LISTS_COUNT
+static size_t find_nonempty_class(FreeLists *lists, size_t sizeClass) {
+    if (sizeClass >= FREE_LISTS_COUNT) {
+        return FREE_LISTS_COUNT;
+    }
+    auto firstLevel = sizeClass / SECOND_LEVEL_COUNT;
+    auto secondLevel = sizeClass % SECOND_LEVEL_COUNT;
+
+    uint32_t secondLevelMap = lists->secondLevelMaps[firstLevel] & (~uint32_t(0) << secondLevel);
+    if (secondLevelMap == 0) {
+        uint64_t firstLevels = lists->firstLevelMap & (~uint64_t(0) << (firstLevel + 1));
+        if (firstLevels == 0) {
+            return FREE_LISTS_COUNT;
+        }
+        firstLevel = __builtin_ctzll(firstLevels);
+        secondLevelMap = lists->secondLevelMaps[firstLevel];
+    }
+    return firstLevel * SECOND_LEVEL_COUNT + __builtin_ctz(secondLevelMap);
+}
+
+void free_list_push(FreeLists *lists, Block *block) {
+    auto sizeClass = get_size_class(get_size(block));
+    auto head = lists->heads[sizeClass];
+
+    set_prev_free_link(block, nullptr);
+    set_next_free_link(block, head);
+    if (head != nullptr) {
+        set_prev_free_link(head, block);
+    }
+    lists->heads[sizeClass] = block;
+
+    auto firstLevel = sizeClass / SECOND_LEVEL_COUNT;
+    lists->secondLevelMaps[firstLevel] |= uint32_t(1) << (sizeClass % SECOND_LEVEL_COUNT);
+    lists->firstLevelMap |= uint64_t(1) << firstLevel;
+}
+
+void free_list_remove(FreeLists *lists, Block *block) {
+    auto prev = get_prev_free_link(block);
+    auto next = get_next_free_link(block);
+    auto sizeClass = get_size_class(get_size(block));
+
+    if (lists->rovers[sizeClass] == block) {
+        lists->rovers[sizeClass] = next;
+    }
+
+    if (prev != nullptr) {
+        set_next_free_link(prev, next);
+    } else {
+        lists->heads[sizeClass] = next;
+    }
+    if (next != nullptr) {
+        set_prev_free_link(next, prev);
+    }
+
+    if (lists->heads[sizeClass] == nullptr) {
+        auto firstLevel = sizeClass / SECOND_LEVEL_COUNT;
+        lists->secondLevelMaps[firstLevel] &= ~(uint32_t(1) << (sizeClass % SECOND_LEVEL_COUNT));
+        if (lists->secondLevelMaps[firstLevel] == 0) {
+            lists->firstLevelMap &= ~(uint64_t(1) << firstLevel);
+        }
+    }
+}
+
+Block * free_list_find(FreeLists *lists, size_t size) {
+    auto sizeClass = get_size_class(size);
+
+    // only the request's own class can hold blocks smaller than it
+    for (auto block = lists->heads[sizeClass]; block != nullptr; block = get_next_free_link(block)) {
+        if (get_size(block) >= size) {
+            return block;
+        }
+    }
+    auto i = find_nonempty_class(lists, sizeClass + 1);
+    return i < FREE_LISTS_COUNT ? lists->heads[i] : nullptr;
+}
+
+Block * free_list_find_next(FreeLists *lists, size_t size) {
+    auto sizeClass = get_size_class(size);
+    auto rover = lists->rovers[sizeClass];
+
+    // from the rover to the end of the list, then from the head up to it
+    for (auto block = rover; block != nullptr; block = get_next_free_link(block)) {
+        if (get_size(block) >= size) {
+            return lists->rovers[sizeClass] = block;
+        }
+    }
+    for (auto block = lists->heads[sizeClass]; block != rover; block = get_next_free_link(block)) {
+        if (get_size(block) >= size) {
+            return lists->rovers[sizeClass] = block;
+        }
+    }
+    auto i = find_nonempty_class(lists, sizeClass + 1);
+    if (i == FREE_LISTS_COUNT) {
+        return nullptr;
+    }
+    return lists->rovers[i] = lists->rovers[i] != nullptr ? lists->rovers[i] : lists->heads[i];
+}
+
+// smallest block of the list that holds the given size
+static Block * find_smallest(Block *head, size_t size) {
+    Block *best = nullptr;
+    for (auto block = head; block != nullptr; block = get_next_free_link(block)) {
+        if (get_size(block) >= size && (best == nullptr || get_size(block) < get_size(best))) {
+            best = block;
+            if (get_size(best) == size) {
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+Block * free_list_find_best(FreeLists *lists, size_t size) {
+    auto sizeClass = get_size_class(size);
+
+    // classes are ordered by size, so the first class with a fitting
+    // block holds the best one; the bitmaps skip the empty ones
+    if (auto best = find_smallest(lists->heads[sizeClass], size)) {
+        return best;
+    }
+    auto i = find_nonempty_class(lists, sizeClass + 1);
+    return i < FREE_LISTS_COUNT ? find_smallest(lists->heads[i], size) : nullptr;
+}
+
+Block * free_list_find_good(FreeLists *lists, size_t size) {
+    // take the head of the first class where every block fits, two bit
+    // scans and no list walk, and only walk the request's own class
+    // as a last resort
+    auto sizeClass = get_size_class(size);
+    auto i = find_nonempty_class(lists, get_fit_class(size));
+    if (i < FREE_LISTS_COUNT) {
+        return lists->heads[i];
+    }
+    if (get_fit_class(size) == sizeClass) {
+        return nullptr;
+    }
+    for (auto block = lists->heads[sizeClass]; block != nullptr; block = get_next_free_link(block)) {
+        if (get_size(block) >= size) {
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+size_t free_list_largest(FreeLists *lists) {
+    if (lists->firstLevelMap == 0) {
+        return 0;
+    }
+    // only the last nonempty class holds candidates
+    auto firstLevel = 63 - __builtin_clzll(lists->firstLevelMap);
+    auto secondLevel = 31 - __builtin_clz(lists->secondLevelMaps[firstLevel]);
+    size_t largest = 0;
+    for (auto block = lists->heads[firstLevel * SECOND_LEVEL_COUNT + secondLevel];
+         block != nullptr; block = get_next_free_link(block)) {
+        largest = std::max(largest, get_size(block));
+    }
+    return largest;
+}
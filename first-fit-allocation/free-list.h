@@ -0,0 +1,51 @@
+#include <cstdint>
+#include "memory-block.h"
+
+#ifndef MEMORYALLOCATOR_FREE_LIST_H
+#define MEMORYALLOCATOR_FREE_LIST_H
+
+//
+// Two-level (TLSF-style) index of free blocks: the first level is the
+// power of two of the size, the second level splits it into SECOND_LEVEL_COUNT
+// equal ranges. Sizes below SMALL_SIZE_LIMIT get one exact class per word.
+//
+
+#define SECOND_LEVEL_SHIFT 4
+#define SECOND_LEVEL_COUNT (1 << SECOND_LEVEL_SHIFT)
+#define SMALL_SIZE_LIMIT (SECOND_LEVEL_COUNT * sizeof(word_t))
+#define FIRST_LEVEL_COUNT 42
+#define FREE_LISTS_COUNT (FIRST_LEVEL_COUNT * SECOND_LEVEL_COUNT)
+
+// Lists of free blocks threaded through their payload, one per class.
+// Bit `i` of the first level map is set while the second level map `i`
+// is not empty, bit `j` of a second level map while its list `j` is not.
+struct FreeLists {
+    Block *heads[FREE_LISTS_COUNT];
+    uint64_t firstLevelMap;
+    uint32_t secondLevelMaps[FIRST_LEVEL_COUNT];
+    // next-fit resumes every class scan where the previous one stopped
+    Block *rovers[FREE_LISTS_COUNT];
+};
+
+// class a free block of the given size is listed in
+size_t get_size_class(size_t size);
+
+// first class whose every block can hold the given size
+size_t get_fit_class(size_t size);
+
+void free_list_push(FreeLists *lists, Block *block);
+
+void free_list_remove(FreeLists *lists, Block *block);
+
+Block * free_list_find(FreeLists *lists, size_t size);
+
+Block * free_list_find_next(FreeLists *lists, size_t size);
+
+Block * free_list_find_best(FreeLists *lists, size_t size);
+
+Block * free_list_find_good(FreeLists *lists, size_t size);
+
+// size of the largest listed block, 0 if there is none
+size_t free_list_largest(FreeLists *lists);
+
+#endif //MEMORYALLOCATOR_FREE_LIST_H
@@ -75,7 +75,8 @@ int main(int argc, char const *argv[]) {
     mem_dump("Operation 8: Free 2 bytes allocated above, empty blocks are merged");
 
     assert(get_next(p4b) == nullptr);
-    assert(get_size(p4b) == 16);
+    // two 8-byte payloads plus the header of the absorbed block
+    assert(get_size(p4b) == 24);
 
     //
     // --------------------------------------
@@ -100,7 +101,8 @@ int main(int argc, char const *argv[]) {
     assert(p7 == p6);
 
     auto p7b = get_mem_block(p7);
-    assert(get_size(p7b) == 16);
+    // the 8-byte rest is too small to be split off with its own header
+    assert(get_size(p7b) == 24);
     assert(p7b == p6b);
 
     // decrease size
@@ -137,5 +139,30 @@ int main(int argc, char const *argv[]) {
     assert(get_size(p11b) == 32);
     assert(is_used(p11b));
 
+    // --------------------------------------
+    // Test case 8: Policies find a fitting block of the request's own class
+    //
+
+    // the free block that fits is the last one, which must not be grown
+    auto goodHeap = heap_create();
+    heap_alloc(goodHeap, 8);
+    auto g1 = heap_alloc(goodHeap, 536);
+    heap_free(goodHeap, g1);
+    auto g2 = heap_alloc_with<GoodFit>(goodHeap, 520);
+    assert(g2 == g1);
+    heap_destroy(goodHeap);
+
+    // the best fit is the smallest fitting block, not the head of its class
+    auto bestHeap = heap_create();
+    heap_alloc(bestHeap, 8);
+    auto b1 = heap_alloc(bestHeap, 512);
+    heap_alloc(bestHeap, 8);
+    auto b2 = heap_alloc(bestHeap, 536);
+    heap_free(bestHeap, b2);
+    heap_free(bestHeap, b1);
+    auto b3 = heap_alloc_with<BestFit>(bestHeap, 520);
+    assert(b3 == b2);
+    heap_destroy(bestHeap);
+
     puts("\nAll tests passed!\n");
 }
\ No newline at end of file
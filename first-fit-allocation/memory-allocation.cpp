@@ -1,14 +1,28 @@
 #include <utility>
+#include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <sched.h>
 #include "memory-allocation.h"
 #include "memory-block.h"
+#include "free-list.h"
 #include "sbrk.h"
 
+#ifdef ALLOCATION_TRACE
+#include "trace.h"
+#endif
+#ifdef HEAP_PROFILE
+#include "profile.h"
+#endif
+
 //
 // bytes alignment and size utils
 //
 
-inline size_t align(size_t n) {
+size_t align(size_t n) {
     return (n + sizeof(word_t) - 1) & ~(sizeof(word_t) - 1);
 }
 
@@ -25,10 +39,70 @@ Block * get_mem_block(word_t *data) {
     return (Block *)((char *)data + sizeof(std::declval<Block>().data) - sizeof(Block));
 }
 
-Block * request_mem_from_os(size_t size) {
-    auto block = (Block *)sbrk(0);
+//
+// statistics
+//
+
+// a heap counter, from under the heap's lock
+inline void count(std::atomic<size_t> &counter, size_t value = 1) {
+#ifndef NO_ALLOCATOR_STATS
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+inline void raise(std::atomic<size_t> &peak, size_t value) {
+#ifndef NO_ALLOCATOR_STATS
+    if (value > peak.load(std::memory_order_relaxed)) {
+        peak.store(value, std::memory_order_relaxed);
+    }
+#else
+    (void)peak;
+    (void)value;
+#endif
+}
+
+// first level of get_size_class, worked out inline
+inline size_t get_stats_class(size_t size) {
+    if (size < SMALL_SIZE_LIMIT) {
+        return 0;
+    }
+    size_t log = 63 - __builtin_clzl(size);
+    return std::min(log - (SECOND_LEVEL_SHIFT + 3) + 1, size_t(FIRST_LEVEL_COUNT - 1));
+}
+
+inline void count_alloc(HeapCounters *counters, size_t size) {
+    count(counters->classes[get_stats_class(size)].allocations);
+    count(counters->bytesInUse, size);
+    raise(counters->peakBytesInUse, counters->bytesInUse.load(std::memory_order_relaxed));
+}
+
+inline void count_free(HeapCounters *counters, size_t size) {
+    count(counters->classes[get_stats_class(size)].frees);
+    count(counters->bytesInUse, -size);
+}
+
+inline void count_resize(HeapCounters *counters, size_t oldSize, size_t newSize) {
+    count(counters->bytesInUse, newSize - oldSize);
+    raise(counters->peakBytesInUse, counters->bytesInUse.load(std::memory_order_relaxed));
+}
 
-    if (sbrk(get_alloc_size(size)) == nullptr) {
+// reservation_sbrk, counting the commits it makes
+void * heap_sbrk(Heap *heap, size_t size) {
+    auto commit = heap->space.commit;
+    auto oldBreak = reservation_sbrk(&heap->space, size);
+    if (heap->space.commit != commit) {
+        count(heap->counters.osRequests);
+    }
+    return oldBreak;
+}
+
+Block * request_mem_from_os(Heap *heap, size_t size) {
+    auto block = (Block *)reservation_sbrk(&heap->space, 0);
+
+    if (heap_sbrk(heap, get_alloc_size(size)) == nullptr) {
         std::cerr << "Out of memory exception!\n";
         return nullptr;
     }
@@ -36,42 +110,163 @@ Block * request_mem_from_os(size_t size) {
     return block;
 }
 
+//
+// blocks with a mapping of their own
+//
+
+// set by any thread, read unlocked by the allocating ones
+static std::atomic<size_t> mmapThreshold(MMAP_THRESHOLD);
+
+// mapped blocks belong to no heap, and any thread maps and unmaps them
+static HeapCounters mappedCounters;
+static std::atomic<size_t> mappedBlocks;
+static std::atomic<size_t> mappedBytes;
+
+void count_mapping(size_t size, size_t length, bool mapped) {
+#ifndef NO_ALLOCATOR_STATS
+    auto sizeClass = get_stats_class(size);
+    mappedCounters.osRequests.fetch_add(1, std::memory_order_relaxed);
+    if (mapped) {
+        mappedCounters.classes[sizeClass].allocations.fetch_add(1, std::memory_order_relaxed);
+        mappedBlocks.fetch_add(1, std::memory_order_relaxed);
+        mappedBytes.fetch_add(length, std::memory_order_relaxed);
+        auto inUse = mappedCounters.bytesInUse.fetch_add(size, std::memory_order_relaxed) + size;
+        auto peak = mappedCounters.peakBytesInUse.load(std::memory_order_relaxed);
+        while (inUse > peak && !mappedCounters.peakBytesInUse.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+        }
+    } else {
+        mappedCounters.classes[sizeClass].frees.fetch_add(1, std::memory_order_relaxed);
+        mappedBlocks.fetch_sub(1, std::memory_order_relaxed);
+        mappedBytes.fetch_sub(length, std::memory_order_relaxed);
+        mappedCounters.bytesInUse.fetch_sub(size, std::memory_order_relaxed);
+    }
+#else
+    (void)size;
+    (void)length;
+    (void)mapped;
+#endif
+}
+
+void mem_set_mmap_threshold(size_t threshold) {
+    mmapThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+inline size_t get_mapping_size(size_t size) {
+    auto pageSize = get_page_size();
+    return (get_alloc_size(size) + pageSize - 1) & ~(pageSize - 1);
+}
+
+// the header sits at the start of the mapping, and the block
+// takes the whole mapping, so its size gives the length back
+Block * map_block(size_t size) {
+    auto length = get_mapping_size(size);
+    auto memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Out of memory exception!\n";
+        return nullptr;
+    }
+    auto block = (Block *)memory;
+    block->header = (length - get_alloc_size(0)) | MAPPED_FLAGS;
+    count_mapping(get_size(block), length, true);
+    return block;
+}
+
+void unmap_block(Block *block) {
+    count_mapping(get_size(block), get_alloc_size(get_size(block)), false);
+    munmap(block, get_alloc_size(get_size(block)));
+}
+
+// the kernel moves the pages, no bytes are copied
+Block * remap_block(Block *block, size_t size) {
+    auto length = get_mapping_size(size);
+    auto memory = mremap(block, get_alloc_size(get_size(block)), length, MREMAP_MAYMOVE);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    // counted as an unmapping and a new mapping
+    count_mapping(get_size((Block *)memory), get_alloc_size(get_size((Block *)memory)), false);
+    block = (Block *)memory;
+    set_size(block, length - get_alloc_size(0));
+    count_mapping(get_size(block), length, true);
+    return block;
+}
+
 //
 // memory block manipulation utils
 //
 
+// keep the successor's boundary tag in sync with the block state
+void mark_free(Block *block) {
+    set_used(block, false);
+    write_footer(block);
+    set_prev_free(get_following(block), block);
+}
+
+void mark_used(Block *block) {
+    set_used(block, true);
+    set_prev_free(get_following(block), nullptr);
+}
+
 bool can_merge(Block *block) {
     auto nextBlock = get_next(block);
     return nextBlock != nullptr && !is_used(nextBlock);
 }
 
-Block * merge(Block *block) {
+Block * merge(Heap *heap, Block *block) {
     auto nextBlock = get_next(block);
-    block->header += get_size(nextBlock);
+    free_list_remove(&heap->freeLists, nextBlock);
+    set_size(block, get_size(block) + get_alloc_size(get_size(nextBlock)));
+    count(heap->counters.coalesces);
     return block;
 }
 
+Block * merge_prev(Heap *heap, Block *block) {
+    auto prevBlock = get_prev(block);
+    free_list_remove(&heap->freeLists, prevBlock);
+    set_size(prevBlock, get_size(prevBlock) + get_alloc_size(get_size(block)));
+    count(heap->counters.coalesces);
+    return prevBlock;
+}
+
 bool can_split(Block *block, size_t size) {
-    return get_size(block) > size;
+    // the rest must fit a header and the smallest payload
+    return get_size(block) >= size + get_alloc_size(sizeof(word_t));
 }
 
-Block * split(Block *block, size_t size) {
-//    auto subBlock = block + get_size(block) - size;
-    auto subBlock = (Block *)((char*)block + get_size(block) - size + sizeof(std::declval<Block>().data));
+Block * split(Heap *heap, Block *block, size_t size) {
+    auto subBlock = (Block *)((char *)block->data + size);
+
+    // the block before the rest stays in use, so no prev flags
+    subBlock->header = get_size(block) - get_alloc_size(size);
+    set_size(block, size);
+    count(heap->counters.splits);
 
-    subBlock->header = get_size(block) - size;
-    set_used(subBlock, false);
+    if (can_merge(subBlock)) {
+        merge(heap, subBlock);
+    }
+    mark_free(subBlock);
+    free_list_push(&heap->freeLists, subBlock);
 
     return block;
 }
 
-Block * alloc_on_list(Block *block, size_t size) {
+Block * alloc_on_list(Heap *heap, Block *block, size_t size, bool &zeroed) {
+    zeroed = is_zeroed(block);
+    free_list_remove(&heap->freeLists, block);
     if (can_split(block, size)) {
-        block = split(block, size);
+        block = split(heap, block, size);
+        // the rest keeps the zero payload and the old footer
+        if (zeroed) {
+            set_zeroed(get_following(block));
+        }
+    } else if (zeroed) {
+        clear_footer(block);
+    }
+    if (zeroed) {
+        block->data[0] = 0;
     }
 
-    block->header = size;
-    set_used(block, true);
+    mark_used(block);
 
     return block;
 }
@@ -80,25 +275,11 @@ Block * alloc_on_list(Block *block, size_t size) {
 // find empty memory block algorithm
 //
 
-Block * first_fit(size_t size) {
-    auto block = heapStart;
-
-    while (block != nullptr) {
-        if (is_used(block) || get_size(block) < size) {
-            block = get_next(block);
-            continue;
-        }
-
-        return block;
-    }
-
-    return nullptr;
-}
-
-Block * find_block(size_t size) {
-    auto foundBlock = first_fit(size);
+template <typename Policy>
+Block * find_block(Heap *heap, size_t size, bool &zeroed) {
+    auto foundBlock = Policy::find(&heap->freeLists, size);
     if (foundBlock) {
-        return alloc_on_list(foundBlock, size);
+        return alloc_on_list(heap, foundBlock, size, zeroed);
     } else {
         return foundBlock;
     }
@@ -108,89 +289,252 @@ Block * find_block(size_t size) {
 //  memory allocation and clear functions
 //
 
-word_t * mem_alloc(size_t size) {
-    size = align(size);
+// `zeroed` tells whether the whole payload is known to be zero
+template <typename Policy>
+word_t * alloc_with(Heap *heap, size_t size, bool &zeroed) {
+    // a free block must be able to hold its list links
+    size = size == 0 ? sizeof(word_t) : align(size);
+
+    // ---------------------------------------------------------
+    // 0. Large requests stay out of the heap, so they never pin its top:
+
+    if (size >= mmapThreshold.load(std::memory_order_relaxed)) {
+        auto block = map_block(size);
+        zeroed = true;
+        return block != nullptr ? block->data : nullptr;
+    }
 
     // ---------------------------------------------------------
     // 1. Search for an available free block:
 
-    if (auto block = find_block(size)) {
+    if (auto block = find_block<Policy>(heap, size, zeroed)) {
+        count_alloc(&heap->counters, get_size(block));
         return block->data;
     }
 
     // ---------------------------------------------------------
-    // 2. If block not found in the free list, request from OS:
+    // 2. If the last block is free, grow it by the missing part:
+
+    auto end = (Block *)reservation_sbrk(&heap->space, 0);
+    if (is_prev_free(end)) {
+        auto block = get_prev(end);
+        if (get_size(block) >= size) {
+            // a policy may pass over a fitting block; it has no missing part
+            block = alloc_on_list(heap, block, size, zeroed);
+            count_alloc(&heap->counters, get_size(block));
+            return block->data;
+        }
+        if (heap_sbrk(heap, size - get_size(block)) == nullptr) {
+            std::cerr << "Out of memory exception!\n";
+            return nullptr;
+        }
+        free_list_remove(&heap->freeLists, block);
+        // the part above the old break is zero already
+        zeroed = is_zeroed(block);
+        if (zeroed) {
+            block->data[0] = 0;
+            clear_footer(block);
+            end->header = 0;
+        }
+        set_size(block, size);
+        mark_used(block);
+        count_alloc(&heap->counters, size);
+        return block->data;
+    }
 
-    auto block = request_mem_from_os(size);
+    // ---------------------------------------------------------
+    // 3. Otherwise request a new block from OS:
 
-    block->header = size;
-    set_used(block, true);
+    auto block = request_mem_from_os(heap, size);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    // the end marker's prev flags describe the last block,
+    // and the payload lies above the old break, so it is zero
+    set_size(block, size);
+    mark_used(block);
+    zeroed = true;
+    count_alloc(&heap->counters, size);
 
 
     // Init heap if need:
-    if (heapStart == nullptr) {
-        heapStart = block;
+    if (heap->start == nullptr) {
+        heap->start = block;
     }
 
     // Return user payload:
     return block->data;
 }
 
-word_t * mem_realloc(word_t * data, size_t size) {
-    auto newSize = align(size);
+size_t trim(Heap *heap, size_t pad);
+void free_block(Heap *heap, Block *block);
 
+word_t * realloc_block(Heap *heap, word_t * data, size_t size) {
+    auto newSize = size == 0 ? sizeof(word_t) : align(size);
     auto block = get_mem_block(data);
-    if (block != nullptr) {
-        auto oldSize = get_size(block);
+    auto oldSize = get_size(block);
 
-        if (newSize == oldSize) return data;
-
-        if (newSize < oldSize) {
-            block = split(block, newSize);
+    // ---------------------------------------------------------
+    // 1. Shrink: the tail is split off and merged with a free successor:
 
-            block->header = newSize;
-            set_used(block, true);
+    if (newSize <= oldSize) {
+        if (can_split(block, newSize)) {
+            split(heap, block, newSize);
+        }
+        count_resize(&heap->counters, oldSize, get_size(block));
+        return data;
+    }
 
-            return data;
-        } else {
-            auto nextBlock = get_next(block);
+    // ---------------------------------------------------------
+    // 2. Grow into a free successor:
 
-            if (nextBlock != nullptr) {
-                if (!is_used(nextBlock) && oldSize + get_size(nextBlock) >= newSize) {
-                    merge(block);
+    auto nextBlock = get_next(block);
+    auto nextFree = nextBlock != nullptr && !is_used(nextBlock);
+    auto available = oldSize + (nextFree ? get_alloc_size(get_size(nextBlock)) : 0);
 
-                    block->header = newSize;
-                    set_used(block, true);
+    if (nextFree && available >= newSize) {
+        merge(heap, block);
+        if (can_split(block, newSize)) {
+            split(heap, block, newSize);
+        }
+        mark_used(block);
+        count_resize(&heap->counters, oldSize, get_size(block));
+        return data;
+    }
 
-                    return data;
-                } // else go to bottom
-            } else {
-                block->header = newSize;
-                set_used(block, true);
+    // ---------------------------------------------------------
+    // 3. Last block (maybe followed by free space): move the break.
+    //    Large blocks rather go to a mapping, so they never pin the top:
 
-                return data;
-            }
+    auto atBreak = nextBlock == nullptr || (nextFree && get_next(nextBlock) == nullptr);
+    if (atBreak && newSize < mmapThreshold.load(std::memory_order_relaxed) && heap_sbrk(heap, newSize - available) != nullptr) {
+        if (nextFree) {
+            merge(heap, block);
         }
+        set_size(block, newSize);
+        mark_used(block);
+        count_resize(&heap->counters, oldSize, newSize);
+        return data;
     }
 
-    auto resData = mem_alloc(newSize);
-    auto newBlock = get_mem_block(resData);
-    newBlock->data[1] = * data;
+    // ---------------------------------------------------------
+    // 4. Grow into a free predecessor, sliding the payload down:
 
-    set_used(block, false);
+    auto prevBlock = get_prev(block);
+    if (prevBlock != nullptr && get_alloc_size(get_size(prevBlock)) + available >= newSize) {
+        if (nextFree) {
+            merge(heap, block);
+        }
+        block = merge_prev(heap, block);
+        memmove(block->data, data, oldSize);
+        if (can_split(block, newSize)) {
+            split(heap, block, newSize);
+        }
+        mark_used(block);
+        count_resize(&heap->counters, oldSize, get_size(block));
+        return block->data;
+    }
+
+    // ---------------------------------------------------------
+    // 5. Move: one copy of the live payload, then free the old block:
 
-    auto next = get_next(newBlock);
+    bool zeroed;
+    auto resData = alloc_with<DefaultPlacement>(heap, newSize, zeroed);
+    if (resData == nullptr) {
+        return nullptr;
+    }
+    memcpy(resData, data, oldSize);
+    free_block(heap, block);
 
     return resData;
+}
 
+void purge(Block *block) {
+    auto pageSize = get_page_size();
+    auto begin = (char *)(block->data + 1);
+    auto end = (char *)get_following(block) - sizeof(size_t);
+    auto pageBegin = (char *)(((uintptr_t)begin + pageSize - 1) & ~(pageSize - 1));
+    auto pageEnd = (char *)((uintptr_t)end & ~(pageSize - 1));
+
+    // whole pages go back to the OS and read as zeros when touched again,
+    // the bytes around them are cleared by hand
+    memset(begin, 0, pageBegin - begin);
+    memset(pageEnd, 0, end - pageEnd);
+    madvise(pageBegin, pageEnd - pageBegin, MADV_DONTNEED);
+    set_zeroed(block);
 }
 
-void mem_free(word_t *data) {
-    auto block = get_mem_block(data);
-    if (can_merge(block)) {
-        block = merge(block);
+void free_block(Heap *heap, Block *block) {
+    count_free(&heap->counters, get_size(block));
+
+    // a small block freed next to known-zero space is cleared by hand,
+    // together with the headers and links that end up in the middle
+    auto nextBlock = get_next(block);
+    auto nextFree = nextBlock != nullptr && !is_used(nextBlock);
+    auto prevBlock = get_prev(block);
+    auto zeroed = (nextFree || prevBlock != nullptr)
+        && (!nextFree || is_zeroed(nextBlock))
+        && (prevBlock == nullptr || is_zeroed(prevBlock))
+        && get_size(block) <= ZERO_ON_FREE_LIMIT;
+    auto zeroBegin = prevBlock != nullptr ? (char *)block - sizeof(size_t) : (char *)(block->data + 1);
+    auto zeroEnd = nextFree ? (char *)(nextBlock->data + 1) : (char *)get_following(block) - sizeof(size_t);
+
+    if (nextFree) {
+        block = merge(heap, block);
     }
-    set_used(block, false);
+    if (prevBlock != nullptr) {
+        block = merge_prev(heap, block);
+    }
+    if (zeroed && zeroEnd > zeroBegin) {
+        memset(zeroBegin, 0, zeroEnd - zeroBegin);
+    }
+    mark_free(block);
+    if (zeroed) {
+        set_zeroed(block);
+    }
+    free_list_push(&heap->freeLists, block);
+
+    if (get_size(block) >= TRIM_THRESHOLD) {
+        if (get_following(block) == reservation_sbrk(&heap->space, 0)) {
+            trim(heap, 0);
+        } else if (!zeroed) {
+            purge(block);
+            count(heap->counters.osRequests);
+        }
+    }
+}
+
+size_t trim(Heap *heap, size_t pad) {
+    auto end = (Block *)reservation_sbrk(&heap->space, 0);
+    if (end == nullptr || !is_prev_free(end)) {
+        return 0;
+    }
+    auto block = get_prev(end);
+
+    // the first block stays, so the heap walk still has a start
+    auto keep = align(pad);
+    if (block == heap->start && keep == 0) {
+        keep = sizeof(word_t);
+    }
+    if (keep != 0 && get_size(block) <= keep) {
+        return 0;
+    }
+    auto newEnd = keep == 0 ? (char *)block : (char *)block->data + keep;
+    auto released = (size_t)((char *)end - newEnd);
+
+    // the break is cleared on release, so the new end marker reads as
+    // a zero-size header; the block before it is used or is `block`
+    free_list_remove(&heap->freeLists, block);
+    reservation_release(&heap->space, released);
+    count(heap->counters.osRequests);
+    if (keep != 0) {
+        set_size(block, keep);
+        mark_free(block);
+        free_list_push(&heap->freeLists, block);
+    }
+
+    return released;
 }
 
 //
@@ -206,14 +550,415 @@ void print_mem_block(Block * block) {
     std::cout << "]";
 }
 
-void mem_dump(const std::string& message = "") {
+void heap_dump(Heap *heap, const std::string& message) {
+    std::lock_guard<std::mutex> guard(heap->lock);
     if (!message.empty()) {
         std::cout << "\n" << message << "\n";
     }
-    auto block = heapStart;
+    auto block = heap->start;
     while (block != nullptr) {
         print_mem_block(block);
         block = get_next(block);
     }
     std::cout << "\n";
-}
\ No newline at end of file
+}
+
+//
+//  heaps
+//
+
+void push_remote_free(Heap *heap, Block *block) {
+    auto head = heap->remoteFrees.load(std::memory_order_relaxed);
+    do {
+        block->data[0] = (word_t)head;
+    } while (!heap->remoteFrees.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// the owner takes the whole stack at once, so there is no ABA
+void drain_remote_frees(Heap *heap) {
+    if (heap->remoteFrees.load(std::memory_order_relaxed) == nullptr) {
+        return;
+    }
+    auto block = heap->remoteFrees.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+        auto next = (Block *)block->data[0];
+        free_block(heap, block);
+        block = next;
+    }
+}
+
+// every heap, for mem_get_stats
+static Heap *heaps = nullptr;
+static std::mutex heapsLock;
+
+Heap * heap_create() {
+    Reservation space;
+    if (!reservation_init(&space, HEAP_RESERVE_SIZE, HEAP_RESERVE_SIZE)) {
+        std::cerr << "Out of memory exception!\n";
+        return nullptr;
+    }
+
+    // the heap is the first object of its own reservation,
+    // its blocks start right after it
+    auto heap = new (reservation_sbrk(&space, align(sizeof(Heap)))) Heap();
+    heap->space = space;
+    heap->start = nullptr;
+    heap->remoteFrees.store(nullptr, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(heapsLock);
+    heap->next = heaps;
+    heaps = heap;
+    return heap;
+}
+
+void heap_destroy(Heap *heap) {
+    {
+        std::lock_guard<std::mutex> guard(heapsLock);
+        auto link = &heaps;
+        while (*link != heap) {
+            link = &(*link)->next;
+        }
+        *link = heap->next;
+    }
+    {
+        // counted and traced like any other free
+        std::lock_guard<std::mutex> guard(heap->lock);
+        drain_remote_frees(heap);
+    }
+
+    // the heap goes away with the mapping, so work on a copy
+    auto space = heap->space;
+    heap->~Heap();
+    reservation_destroy(&space);
+}
+
+Heap * get_heap_of(word_t *data) {
+    auto block = get_mem_block(data);
+    if (is_mapped(block)) {
+        return nullptr;
+    }
+    return (Heap *)((uintptr_t)block & ~(uintptr_t)(HEAP_RESERVE_SIZE - 1));
+}
+
+word_t * heap_alloc(Heap *heap, size_t size) {
+    return heap_alloc_with<DefaultPlacement>(heap, size);
+}
+
+template <typename Policy>
+word_t * heap_alloc_with(Heap *heap, size_t size) {
+    std::lock_guard<std::mutex> guard(heap->lock);
+    drain_remote_frees(heap);
+    bool zeroed;
+    return alloc_with<Policy>(heap, size, zeroed);
+}
+
+word_t * heap_calloc(Heap *heap, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+
+    // fresh pages are left untouched, so they are not even faulted in
+    bool zeroed;
+    word_t *data;
+    {
+        std::lock_guard<std::mutex> guard(heap->lock);
+        drain_remote_frees(heap);
+        data = alloc_with<DefaultPlacement>(heap, count * size, zeroed);
+    }
+    if (data != nullptr && !zeroed) {
+        memset(data, 0, count * size);
+    }
+    return data;
+}
+
+void add_counters(MemStats *stats, HeapCounters *counters) {
+    for (int i = 0; i < FIRST_LEVEL_COUNT; i++) {
+        stats->allocations[i] += counters->classes[i].allocations.load(std::memory_order_relaxed);
+        stats->frees[i] += counters->classes[i].frees.load(std::memory_order_relaxed);
+    }
+    stats->bytesInUse += counters->bytesInUse.load(std::memory_order_relaxed);
+    stats->peakBytesInUse += counters->peakBytesInUse.load(std::memory_order_relaxed);
+    stats->splits += counters->splits.load(std::memory_order_relaxed);
+    stats->coalesces += counters->coalesces.load(std::memory_order_relaxed);
+    stats->osRequests += counters->osRequests.load(std::memory_order_relaxed);
+}
+
+MemStats heap_get_stats(Heap *heap) {
+    MemStats stats = {};
+    std::lock_guard<std::mutex> guard(heap->lock);
+    drain_remote_frees(heap);
+    add_counters(&stats, &heap->counters);
+    stats.bytesReserved = heap->space.commit - heap->space.begin;
+    stats.largestFreeBlock = free_list_largest(&heap->freeLists);
+    return stats;
+}
+
+void heap_free(Heap *heap, word_t *data) {
+    std::lock_guard<std::mutex> guard(heap->lock);
+    drain_remote_frees(heap);
+    free_block(heap, get_mem_block(data));
+}
+
+size_t heap_trim(Heap *heap, size_t pad) {
+    std::lock_guard<std::mutex> guard(heap->lock);
+    drain_remote_frees(heap);
+    return trim(heap, pad);
+}
+
+template word_t * heap_alloc_with<FirstFit>(Heap *heap, size_t size);
+template word_t * heap_alloc_with<NextFit>(Heap *heap, size_t size);
+template word_t * heap_alloc_with<BestFit>(Heap *heap, size_t size);
+template word_t * heap_alloc_with<GoodFit>(Heap *heap, size_t size);
+
+//
+//  heap of the calling thread or CPU
+//
+
+#ifdef HEAP_PER_CPU
+
+static Heap * cpuHeaps[HEAP_MAX_CPUS] = {};
+static std::mutex cpuHeapsLock;
+
+static Heap *& get_cpu_heap() {
+    auto cpu = sched_getcpu();
+    return cpuHeaps[(cpu < 0 ? 0 : cpu) % HEAP_MAX_CPUS];
+}
+
+// heap of the caller, without creating one
+Heap * find_own_heap() {
+    return get_cpu_heap();
+}
+
+Heap * mem_get_heap() {
+    auto &heap = get_cpu_heap();
+    if (heap == nullptr) {
+        std::lock_guard<std::mutex> guard(cpuHeapsLock);
+        if (heap == nullptr) {
+            heap = heap_create();
+        }
+    }
+    return heap;
+}
+
+#else
+
+// heaps of exited threads, handed to new threads with their blocks
+static std::vector<Heap *> idleHeaps;
+static std::mutex idleHeapsLock;
+
+struct ThreadHeap {
+    Heap *heap = nullptr;
+
+    ~ThreadHeap() {
+        if (heap != nullptr) {
+            {
+                // nobody drains an idle heap until a thread takes it over
+                std::lock_guard<std::mutex> guard(heap->lock);
+                drain_remote_frees(heap);
+            }
+            std::lock_guard<std::mutex> guard(idleHeapsLock);
+            idleHeaps.push_back(heap);
+        }
+    }
+};
+
+static thread_local ThreadHeap threadHeap;
+
+// heap of the caller, without creating one
+Heap * find_own_heap() {
+    return threadHeap.heap;
+}
+
+Heap * mem_get_heap() {
+    if (threadHeap.heap == nullptr) {
+        {
+            std::lock_guard<std::mutex> guard(idleHeapsLock);
+            if (!idleHeaps.empty()) {
+                threadHeap.heap = idleHeaps.back();
+                idleHeaps.pop_back();
+            }
+        }
+        if (threadHeap.heap == nullptr) {
+            threadHeap.heap = heap_create();
+        }
+    }
+    return threadHeap.heap;
+}
+
+#endif
+
+void init_heap() {
+    mem_get_heap();
+}
+
+word_t * mem_alloc(size_t size) {
+    return mem_alloc_with<DefaultPlacement>(size);
+}
+
+template <typename Policy>
+word_t * mem_alloc_with(size_t size) {
+    auto heap = mem_get_heap();
+    if (heap == nullptr) {
+        return nullptr;
+    }
+    auto data = heap_alloc_with<Policy>(heap, size);
+#ifdef ALLOCATION_TRACE
+    if (data != nullptr) {
+        trace_alloc(data, size);
+    }
+#endif
+#ifdef HEAP_PROFILE
+    heap_profile_alloc(data, size);
+#endif
+    return data;
+}
+
+template word_t * mem_alloc_with<FirstFit>(size_t size);
+template word_t * mem_alloc_with<NextFit>(size_t size);
+template word_t * mem_alloc_with<BestFit>(size_t size);
+template word_t * mem_alloc_with<GoodFit>(size_t size);
+
+word_t * mem_calloc(size_t count, size_t size) {
+    auto heap = mem_get_heap();
+    if (heap == nullptr) {
+        return nullptr;
+    }
+    auto data = heap_calloc(heap, count, size);
+#ifdef ALLOCATION_TRACE
+    if (data != nullptr) {
+        trace_alloc(data, count * size);
+    }
+#endif
+#ifdef HEAP_PROFILE
+    heap_profile_alloc(data, count * size);
+#endif
+    return data;
+}
+
+static word_t * realloc_data(word_t * data, size_t size) {
+    auto ownHeap = mem_get_heap();
+    if (data == nullptr) {
+        return ownHeap != nullptr ? heap_alloc(ownHeap, size) : nullptr;
+    }
+
+    auto block = get_mem_block(data);
+    if (is_mapped(block)) {
+        auto newSize = size == 0 ? sizeof(word_t) : align(size);
+        if (newSize >= mmapThreshold.load(std::memory_order_relaxed)) {
+            auto newBlock = remap_block(block, newSize);
+            return newBlock != nullptr ? newBlock->data : nullptr;
+        }
+        // small enough for a heap again
+        auto resData = ownHeap != nullptr ? heap_alloc(ownHeap, newSize) : nullptr;
+        if (resData != nullptr) {
+            // the threshold may have been raised above the mapped size
+            memcpy(resData, data, std::min(newSize, get_size(block)));
+            unmap_block(block);
+        }
+        return resData;
+    }
+
+    // the block stays in the heap it came from
+    auto heap = get_heap_of(data);
+    std::lock_guard<std::mutex> guard(heap->lock);
+    return realloc_block(heap, data, size);
+}
+
+word_t * mem_realloc(word_t * data, size_t size) {
+#ifdef ALLOCATION_TRACE
+    auto start = trace_clock();
+#endif
+    auto resData = realloc_data(data, size);
+#ifdef ALLOCATION_TRACE
+    if (resData != nullptr) {
+        trace_realloc(data, resData, size, start);
+    }
+#endif
+#ifdef HEAP_PROFILE
+    // profiled as a free and a new allocation
+    if (resData != nullptr) {
+        if (data != nullptr) {
+            heap_profile_free(data);
+        }
+        heap_profile_alloc(resData, size);
+    }
+#endif
+    return resData;
+}
+
+void mem_free(word_t *data) {
+#ifdef ALLOCATION_TRACE
+    trace_free(data);
+#endif
+#ifdef HEAP_PROFILE
+    heap_profile_free(data);
+#endif
+    auto block = get_mem_block(data);
+    if (is_mapped(block)) {
+        unmap_block(block);
+        return;
+    }
+
+    auto heap = get_heap_of(data);
+    if (heap != find_own_heap()) {
+        push_remote_free(heap, block);
+        return;
+    }
+    std::lock_guard<std::mutex> guard(heap->lock);
+    drain_remote_frees(heap);
+    free_block(heap, block);
+}
+
+size_t mem_trim(size_t pad) {
+    auto heap = mem_get_heap();
+    return heap != nullptr ? heap_trim(heap, pad) : 0;
+}
+
+MemStats mem_get_stats() {
+    MemStats stats = {};
+    add_counters(&stats, &mappedCounters);
+    stats.bytesReserved = mappedBytes.load(std::memory_order_relaxed);
+    stats.mappedBlocks = mappedBlocks.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(heapsLock);
+    for (auto heap = heaps; heap != nullptr; heap = heap->next) {
+        std::lock_guard<std::mutex> heapGuard(heap->lock);
+        drain_remote_frees(heap);
+        add_counters(&stats, &heap->counters);
+        stats.bytesReserved += heap->space.commit - heap->space.begin;
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, free_list_largest(&heap->freeLists));
+    }
+    return stats;
+}
+
+// in the order the other paths nest them
+void mem_lock_all() {
+#ifdef HEAP_PER_CPU
+    cpuHeapsLock.lock();
+#else
+    idleHeapsLock.lock();
+#endif
+    heapsLock.lock();
+    for (auto heap = heaps; heap != nullptr; heap = heap->next) {
+        heap->lock.lock();
+    }
+}
+
+void mem_unlock_all() {
+    for (auto heap = heaps; heap != nullptr; heap = heap->next) {
+        heap->lock.unlock();
+    }
+    heapsLock.unlock();
+#ifdef HEAP_PER_CPU
+    cpuHeapsLock.unlock();
+#else
+    idleHeapsLock.unlock();
+#endif
+}
+
+void mem_dump(const std::string& message = "") {
+    auto heap = mem_get_heap();
+    if (heap != nullptr) {
+        heap_dump(heap, message);
+    }
+}
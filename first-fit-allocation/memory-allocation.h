@@ -1,20 +1,151 @@
+#include <atomic>
+#include <mutex>
+#include <string>
 #include "memory-block.h"
+#include "free-list.h"
+#include "placement-policy.h"
+#include "sbrk.h"
 
 #ifndef MEMORYALLOCATOR_MEMORY_ALLOCATION_H
 #define MEMORYALLOCATOR_MEMORY_ALLOCATION_H
 
-static Block * heapStart = nullptr;
+// mem_free gives free space of at least this size back to the OS:
+// at the top of the heap by trimming, inside it with MADV_DONTNEED
+#define TRIM_THRESHOLD (256 * 1024)
+
+// blocks up to this size freed next to known-zero space are cleared,
+// so that the coalesced block stays known zero
+#define ZERO_ON_FREE_LIMIT 4096
+
+// requests of at least this size get a mapping of their own
+#ifndef MMAP_THRESHOLD
+#define MMAP_THRESHOLD (128 * 1024)
+#endif
+
+// heaps shared by the threads running on a CPU, with -DHEAP_PER_CPU
+#define HEAP_MAX_CPUS 256
+
+// Counters of a heap, written under its lock and read from anywhere:
+// with a single writer, relaxed loads and stores are enough. Built with
+// -DNO_ALLOCATOR_STATS, they are never written.
+struct HeapCounters {
+    std::atomic<size_t> bytesInUse;
+    std::atomic<size_t> peakBytesInUse;
+    std::atomic<size_t> splits;
+    std::atomic<size_t> coalesces;
+    std::atomic<size_t> osRequests;
+    // allocations and frees of a class share a cache line
+    struct {
+        std::atomic<size_t> allocations;
+        std::atomic<size_t> frees;
+    } classes[FIRST_LEVEL_COUNT];
+};
+
+// A first-fit heap with its own reservation, break and free lists.
+// The heap is the first object of its reservation, which is aligned to
+// HEAP_RESERVE_SIZE, so every heap block leads back to its heap.
+struct Heap {
+    Reservation space;
+    Block *start;
+    FreeLists freeLists;
+    // taken by the heap's own threads
+    std::mutex lock;
+    // blocks freed by other threads, pushed without the lock and linked
+    // through their first word; drained whenever the heap is locked to
+    // allocate, free, trim, report or be parked
+    std::atomic<Block *> remoteFrees;
+    HeapCounters counters;
+    // all heaps, for mem_get_stats
+    Heap *next;
+};
+
+// Snapshot of allocator counters. Size classes are the first level of
+// the free-list index: below 128 bytes, then one per power of two.
+struct MemStats {
+    size_t allocations[FIRST_LEVEL_COUNT];
+    size_t frees[FIRST_LEVEL_COUNT];
+    // payload bytes of used blocks, mapped ones included
+    size_t bytesInUse;
+    size_t peakBytesInUse;
+    // committed heap pages and mappings
+    size_t bytesReserved;
+    size_t splits;
+    size_t coalesces;
+    // commits, releases and purges of heap pages, mmap/mremap/munmap calls
+    size_t osRequests;
+    size_t largestFreeBlock;
+    size_t mappedBlocks;
+};
 
 size_t align(size_t n);
 
 Block * get_mem_block(word_t *data);
 
+Heap * heap_create();
+
+// unmaps the heap with all its blocks
+void heap_destroy(Heap *heap);
+
+// heap a block was allocated from, nullptr for mapped blocks
+Heap * get_heap_of(word_t *data);
+
+word_t * heap_alloc(Heap *heap, size_t size);
+
+template <typename Policy>
+word_t * heap_alloc_with(Heap *heap, size_t size);
+
+word_t * heap_calloc(Heap *heap, size_t count, size_t size);
+
+// frees a block of `heap` right away, under its lock
+void heap_free(Heap *heap, word_t *data);
+
+size_t heap_trim(Heap *heap, size_t pad = 0);
+
+// the heap's counters; takes its lock for a moment to take in remote
+// frees and find the largest free block
+MemStats heap_get_stats(Heap *heap);
+
+void heap_dump(Heap *heap, const std::string& message = "");
+
+//
+// mem_* functions allocate from the calling thread's heap, or from the
+// heap of the CPU it runs on with -DHEAP_PER_CPU. Blocks are reallocated
+// and freed in the heap they came from, by any thread: a block of
+// another heap is queued to it without taking its lock.
+//
+
+// heap of the calling thread or CPU, created on first use; nullptr if
+// there is no address space left for one, and mem_* then fail
+Heap * mem_get_heap();
+
+void init_heap();
+
 word_t * mem_alloc(size_t size);
 
+template <typename Policy>
+word_t * mem_alloc_with(size_t size);
+
+word_t * mem_calloc(size_t count, size_t size);
+
 word_t * mem_realloc(word_t * data, size_t size);
 
 void mem_free(word_t *data);
 
+void mem_set_mmap_threshold(size_t threshold);
+
+// Releases the trailing free block, keeping `pad` bytes of it,
+// and returns the number of bytes given back to the OS.
+size_t mem_trim(size_t pad = 0);
+
+// All heaps and mapped blocks together. The peak is the sum of the
+// peaks, so it is an upper bound.
+MemStats mem_get_stats();
+
+// Takes every lock of the mem_* functions, e.g. to hold them across
+// fork() so that the child finds none taken mid-operation.
+void mem_lock_all();
+void mem_unlock_all();
+
 void mem_dump(const std::string& message);
 
 #endif //MEMORYALLOCATOR_MEMORY_ALLOCATION_H
@@ -1,26 +1,156 @@
+#include <cstring>
 #include <iostream>
 #include "memory-block.h"
+#include "sbrk.h"
 
 size_t get_size(Block *block) {
-    // get all without least-significant bit
-    return block->header & ~1uL;
+    // get all without the flag bits
+    return block->header & ~size_t(BLOCK_FLAGS);
+}
+
+void set_size(Block *block, size_t size) {
+    block->header = size | (block->header & BLOCK_FLAGS);
 }
 
 bool is_used(Block *block) {
     // get least-significant bit
-    return block->header & 1u;
+    return block->header & USED_FLAG;
 }
 
 void set_used(Block *block, bool used) {
     // set 1 | 0 to least-significant bit
     if (used) {
-        block->header |= 1u;
+        block->header |= USED_FLAG;
     } else {
-        block->header &= ~1u;
+        block->header &= ~size_t(USED_FLAG);
     }
 }
 
+Block * get_following(Block *block) {
+    // next header, or the zero-size end marker at the break
+    return (Block *)((char*)block + get_size(block) + sizeof(std::declval<Block>().data));
+}
+
 Block * get_next(Block * block) {
-    auto nextBlock = (Block *)((char*)block + get_size(block) + sizeof(std::declval<Block>().data));
+    auto nextBlock = get_following(block);
     return get_size(nextBlock) > 0 ? nextBlock : nullptr;
 }
+
+//
+// boundary tags
+//
+
+// Footers and links sit in payload words typed word_t, so they are
+// copied in and out rather than read through a pointer of another type.
+
+static size_t read_word(void *address) {
+    size_t value;
+    memcpy(&value, address, sizeof(value));
+    return value;
+}
+
+static void write_word(void *address, size_t value) {
+    memcpy(address, &value, sizeof(value));
+}
+
+static void * get_footer(Block *block) {
+    return (char *)get_following(block) - sizeof(size_t);
+}
+
+bool is_mapped(Block *block) {
+    return (block->header & (PREV_FREE_FLAG | PREV_MINIMAL_FLAG)) == PREV_MINIMAL_FLAG;
+}
+
+bool is_prev_free(Block *block) {
+    return block->header & PREV_FREE_FLAG;
+}
+
+void set_prev_free(Block *block, Block *prev) {
+    block->header &= ~size_t(PREV_FREE_FLAG | PREV_MINIMAL_FLAG);
+    if (prev != nullptr) {
+        block->header |= PREV_FREE_FLAG;
+        if (get_size(prev) == sizeof(word_t)) {
+            block->header |= PREV_MINIMAL_FLAG;
+        }
+    }
+}
+
+Block * get_prev(Block *block) {
+    if (!is_prev_free(block)) {
+        return nullptr;
+    }
+    auto prevSize = (block->header & PREV_MINIMAL_FLAG)
+        ? sizeof(word_t)
+        : read_word((char *)block - sizeof(size_t)) & ~size_t(BLOCK_FLAGS);
+    return (Block *)((char *)block - prevSize - sizeof(block->header));
+}
+
+void write_footer(Block *block) {
+    if (get_size(block) > sizeof(word_t)) {
+        write_word(get_footer(block), get_size(block));
+    }
+}
+
+void clear_footer(Block *block) {
+    if (get_size(block) > sizeof(word_t)) {
+        write_word(get_footer(block), 0);
+    }
+}
+
+// a new footer clears the flag, so any rewrite of a free block
+// drops the zero state unless it is set again
+bool is_zeroed(Block *block) {
+    return get_size(block) > sizeof(word_t)
+        && (read_word(get_footer(block)) & ZEROED_FLAG);
+}
+
+void set_zeroed(Block *block) {
+    if (get_size(block) > sizeof(word_t)) {
+        write_word(get_footer(block), read_word(get_footer(block)) | ZEROED_FLAG);
+    }
+}
+
+//
+// free list links
+//
+
+static_assert(HEAP_RESERVE_SIZE / sizeof(word_t) <= size_t(INT32_MAX) + 1,
+              "free list links must reach across a whole heap reservation");
+
+static Block * from_link(Block *block, int32_t link) {
+    return link == 0 ? nullptr : (Block *)((word_t *)block + link);
+}
+
+static int32_t to_link(Block *block, Block *target) {
+    return target == nullptr ? 0 : int32_t((word_t *)target - (word_t *)block);
+}
+
+static FreeLinks read_links(Block *block) {
+    FreeLinks links;
+    memcpy(&links, block->data, sizeof(links));
+    return links;
+}
+
+static void write_links(Block *block, FreeLinks links) {
+    memcpy(block->data, &links, sizeof(links));
+}
+
+Block * get_next_free_link(Block *block) {
+    return from_link(block, read_links(block).next);
+}
+
+Block * get_prev_free_link(Block *block) {
+    return from_link(block, read_links(block).prev);
+}
+
+void set_next_free_link(Block *block, Block *next) {
+    auto links = read_links(block);
+    links.next = to_link(block, next);
+    write_links(block, links);
+}
+
+void set_prev_free_link(Block *block, Block *prev) {
+    auto links = read_links(block);
+    links.prev = to_link(block, prev);
+    write_links(block, links);
+}
@@ -1,8 +1,28 @@
 #ifndef MEMORYALLOCATOR_MEMORY_BLOCK_H
 #define MEMORYALLOCATOR_MEMORY_BLOCK_H
 
+#include <cstddef>
+#include <cstdint>
+
 using word_t = intptr_t ;
 
+// Flags in the spare low bits of the header (sizes are word-aligned).
+// A free block of two or more words also ends with a footer holding its
+// size; a one-word free block has no room for it, so PREV_MINIMAL tells
+// its successor the size instead.
+#define USED_FLAG 1u
+#define PREV_FREE_FLAG 2u
+#define PREV_MINIMAL_FLAG 4u
+#define BLOCK_FLAGS 7u
+
+// Low bit of a free block's footer: its payload is known to be zero,
+// apart from the list links and the footer itself.
+#define ZEROED_FLAG 1u
+
+// A block served by its own mapping sets PREV_MINIMAL without PREV_FREE,
+// a combination heap blocks never use.
+#define MAPPED_FLAGS (USED_FLAG | PREV_MINIMAL_FLAG)
+
 struct Block {
     // Object header
     size_t header;
@@ -10,12 +30,49 @@ struct Block {
     word_t data[1];
 };
 
+// Free list links kept in the first payload word of a free block,
+// as signed offsets in words relative to the block itself (0 is null),
+// so that even the smallest 8-byte block can be linked both ways.
+struct FreeLinks {
+    int32_t next;
+    int32_t prev;
+};
+
 size_t get_size(Block *block);
 
+void set_size(Block *block, size_t size);
+
 bool is_used(Block *block);
 
 void set_used(Block *block, bool used);
 
+Block * get_following(Block *block);
+
 Block * get_next(Block * block);
 
+bool is_mapped(Block *block);
+
+bool is_prev_free(Block *block);
+
+void set_prev_free(Block *block, Block *prev);
+
+Block * get_prev(Block *block);
+
+void write_footer(Block *block);
+
+// zeroes the footer, which is then payload again
+void clear_footer(Block *block);
+
+bool is_zeroed(Block *block);
+
+void set_zeroed(Block *block);
+
+Block * get_next_free_link(Block *block);
+
+Block * get_prev_free_link(Block *block);
+
+void set_next_free_link(Block *block, Block *next);
+
+void set_prev_free_link(Block *block, Block *prev);
+
 #endif //MEMORYALLOCATOR_MEMORY_BLOCK_H
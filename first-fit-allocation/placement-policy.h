@@ -0,0 +1,48 @@
+#include "free-list.h"
+
+#ifndef MEMORYALLOCATOR_PLACEMENT_POLICY_H
+#define MEMORYALLOCATOR_PLACEMENT_POLICY_H
+
+//
+// Placement policies choose the free block a request is carved from.
+// They are plain types passed to mem_alloc_with<Policy>, so the choice
+// is made at compile time and inlined, without a virtual call.
+//
+
+struct FirstFit {
+    // first fitting block of the smallest suitable class
+    static Block * find(FreeLists *lists, size_t size) {
+        return free_list_find(lists, size);
+    }
+};
+
+struct NextFit {
+    // like first-fit, but resumes from where the last search stopped
+    static Block * find(FreeLists *lists, size_t size) {
+        return free_list_find_next(lists, size);
+    }
+};
+
+struct BestFit {
+    // smallest fitting block, walking at most two classes
+    static Block * find(FreeLists *lists, size_t size) {
+        return free_list_find_best(lists, size);
+    }
+};
+
+struct GoodFit {
+    // head of the first class that is guaranteed to fit, no list walk
+    // unless only the request's own class has a fitting block
+    static Block * find(FreeLists *lists, size_t size) {
+        return free_list_find_good(lists, size);
+    }
+};
+
+// policy used by mem_alloc, e.g. -DPLACEMENT_POLICY=BestFit
+#ifndef PLACEMENT_POLICY
+#define PLACEMENT_POLICY FirstFit
+#endif
+
+using DefaultPlacement = PLACEMENT_POLICY;
+
+#endif //MEMORYALLOCATOR_PLACEMENT_POLICY_H
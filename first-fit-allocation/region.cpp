@@ -0,0 +1,54 @@
+#include "region.h"
+#include "memory-allocation.h"
+
+Region * region_create(size_t reserveSize) {
+    Reservation space;
+    if (!reservation_init(&space, reserveSize)) {
+        return nullptr;
+    }
+
+    // the region header is the first object of its own reservation
+    auto region = (Region *)reservation_sbrk(&space, align(sizeof(Region)));
+    region->space = space;
+    region->base = region->space.brk;
+    region->top = region->base;
+    return region;
+}
+
+word_t * region_alloc(Region *region, size_t size) {
+    size = size == 0 ? sizeof(word_t) : align(size);
+
+    // the break marks what is committed so far, the top what is in use
+    if (size > (size_t)(region->space.brk - region->top)) {
+        auto missing = size - (size_t)(region->space.brk - region->top);
+        if (reservation_sbrk(&region->space, missing) == nullptr) {
+            return nullptr;
+        }
+    }
+
+    auto data = (word_t *)region->top;
+    region->top += size;
+    return data;
+}
+
+RegionMark region_save(Region *region) {
+    return region->top;
+}
+
+void region_restore(Region *region, RegionMark mark) {
+    region->top = mark;
+}
+
+void region_reset(Region *region) {
+    region->top = region->base;
+}
+
+void region_destroy(Region *region) {
+    // the header goes away with the mapping, so work on a copy
+    auto space = region->space;
+    reservation_destroy(&space);
+}
+
+size_t region_used_size(Region *region) {
+    return region->top - region->base;
+}
@@ -0,0 +1,45 @@
+#include "memory-block.h"
+#include "sbrk.h"
+
+#ifndef MEMORYALLOCATOR_REGION_H
+#define MEMORYALLOCATOR_REGION_H
+
+//
+// Regions hand out memory with a bump pointer over a reservation of
+// their own. Objects have no headers and are never freed one by one:
+// the whole region is reset or destroyed at once.
+//
+
+#define REGION_RESERVE_SIZE (size_t(1) << 30) // 1 GB
+
+struct Region {
+    Reservation space;
+    // start of the objects, right after this header
+    char *base;
+    char *top;
+};
+
+// Position of the bump pointer; rolling back to it releases everything
+// allocated since. Savepoints nest, and are rolled back innermost first.
+using RegionMark = char *;
+
+Region * region_create(size_t reserveSize = REGION_RESERVE_SIZE);
+
+word_t * region_alloc(Region *region, size_t size);
+
+// individual objects are released with the region
+inline void region_free(Region *, word_t *) {}
+
+RegionMark region_save(Region *region);
+
+void region_restore(Region *region, RegionMark mark);
+
+// releases all objects, but keeps the pages for the next round
+void region_reset(Region *region);
+
+void region_destroy(Region *region);
+
+// bytes handed out since the region was created or reset
+size_t region_used_size(Region *region);
+
+#endif //MEMORYALLOCATOR_REGION_H
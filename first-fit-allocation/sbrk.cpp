@@ -1,25 +1,97 @@
 #include "sbrk.h"
-#include <sys/mman.h>
-#define MAX_HEAP 4194304 // 4 MB
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
 
-static char * heap ;
-char * brkp = nullptr;
-char * endp = nullptr;
+static char * round_up(Reservation *space, char *address, size_t granularity) {
+    return space->begin + (((size_t)(address - space->begin) + granularity - 1) & ~(granularity - 1));
+}
+
+bool reservation_init(Reservation *space, size_t size, size_t alignment) {
+    // reserve address space only, pages are committed as the break grows
+    auto length = size + alignment;
+    auto mapping = (char *)mmap(nullptr, length, PROT_NONE, (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE), -1, 0);
+    if (mapping == MAP_FAILED) {
+        *space = {};
+        return false;
+    }
 
-void init_heap( ) {
-    heap = (char *)mmap(nullptr, MAX_HEAP, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
-    brkp = heap;
-    endp = brkp + MAX_HEAP;
+    // an aligned start is cut out of a larger mapping
+    auto begin = mapping;
+    if (alignment != 0) {
+        begin = (char *)(((uintptr_t)mapping + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        if (begin > mapping) {
+            munmap(mapping, begin - mapping);
+        }
+        if (begin + size < mapping + length) {
+            munmap(begin + size, mapping + length - (begin + size));
+        }
+    }
+    // the first step is committed up front for the end marker at the break
+    if (mprotect(begin, HEAP_COMMIT_SIZE, PROT_READ | PROT_WRITE) != 0) {
+        munmap(begin, size);
+        *space = {};
+        return false;
+    }
+    *space = {begin, begin, begin + HEAP_COMMIT_SIZE, begin + size};
+    return true;
 }
 
-void * sbrk(size_t size) {
+void * reservation_sbrk(Reservation *space, size_t size) {
     if (size == 0) {
-        return (void*)brkp;
+        return (void*)space->brk;
     }
-    void *free = (void*)brkp;
-    brkp += size;
-    if (brkp >= endp) {
+    if (space->begin == nullptr || size >= (size_t)(space->end - space->brk)) {
         return nullptr;
     }
+
+    // the word at the break (the allocator's end marker) must be accessible too
+    auto needed = space->brk + size + sizeof(size_t);
+    if (needed > space->commit) {
+        auto newCommit = round_up(space, needed, HEAP_COMMIT_SIZE);
+        if (mprotect(space->commit, newCommit - space->commit, PROT_READ | PROT_WRITE) != 0) {
+            return nullptr;
+        }
+        space->commit = newCommit;
+    }
+
+    void *free = (void*)space->brk;
+    space->brk += size;
     return free;
 }
+
+void * reservation_release(Reservation *space, size_t size) {
+    if (size > (size_t)(space->brk - space->begin)) {
+        return nullptr;
+    }
+    space->brk -= size;
+
+    // the tail of the break's page stays resident, so clear it by hand
+    auto pageEnd = round_up(space, space->brk, get_page_size());
+    if (pageEnd > space->commit) {
+        pageEnd = space->commit;
+    }
+    memset(space->brk, 0, pageEnd - space->brk);
+
+    // whole pages go back to the OS, whole commit steps lose their access
+    auto newCommit = round_up(space, space->brk + sizeof(size_t), HEAP_COMMIT_SIZE);
+    if (pageEnd < space->commit) {
+        madvise(pageEnd, space->commit - pageEnd, MADV_DONTNEED);
+    }
+    if (newCommit < space->commit) {
+        mprotect(newCommit, space->commit - newCommit, PROT_NONE);
+        space->commit = newCommit;
+    }
+    return (void*)space->brk;
+}
+
+void reservation_destroy(Reservation *space) {
+    if (space->begin != nullptr) {
+        munmap(space->begin, space->end - space->begin);
+    }
+    *space = {};
+}
+
+size_t get_page_size() {
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
@@ -1,9 +1,39 @@
+#include <cstddef>
 #include <sys/mman.h>
 
 #ifndef MEMORYALLOCATOR_SBRK_H
 #define MEMORYALLOCATOR_SBRK_H
 
-void init_heap();
-void * sbrk(size_t size);
+// Address space reserved for every heap, which is also its alignment;
+// only the part below the break (rounded up to HEAP_COMMIT_SIZE) is
+// backed by accessible pages. Free list links are 32-bit word offsets,
+// so a heap cannot span more than 16 GB.
+#define HEAP_RESERVE_SIZE (size_t(16) << 30) // 16 GB
+#define HEAP_COMMIT_SIZE (size_t(64) << 10)  // 64 KB
+
+// A range of address space with a break of its own, used by heaps and
+// regions. Memory above the break always reads as zeros.
+struct Reservation {
+    char *begin;
+    char *brk;
+    // end of the accessible part
+    char *commit;
+    char *end;
+};
+
+// `alignment`, if given, is a power of two the range starts at
+bool reservation_init(Reservation *space, size_t size, size_t alignment = 0);
+
+// Moves the break up by `size` bytes and returns the old break,
+// or nullptr if the reservation is exhausted. A size of 0 returns the break.
+void * reservation_sbrk(Reservation *space, size_t size);
+
+// Moves the break down by `size` bytes and returns the pages above it
+// to the OS.
+void * reservation_release(Reservation *space, size_t size);
+
+void reservation_destroy(Reservation *space);
+
+size_t get_page_size();
 
 #endif //MEMORYALLOCATOR_SBRK_H
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <execinfo.h>
+#include <sys/mman.h>
+#include "profile.h"
+
+#define NO_SAMPLE UINT32_MAX
+
+struct HeapSample {
+    void *address;
+    size_t size;
+    // bytes the sample stands for
+    double weight;
+    // next sample in the bucket, or in the free list
+    uint32_t next;
+    uint32_t depth;
+    void *frames[HEAP_PROFILE_MAX_FRAMES];
+};
+
+// Live samples hashed by address. Mapped directly so that sampling never
+// calls the allocator being profiled. Frees read the buckets without the
+// lock: a block is only freed after its allocation, and so its sample,
+// has been handed over.
+struct SampleTable {
+    std::atomic<uint32_t> buckets[HEAP_PROFILE_MAX_SAMPLES];
+    HeapSample samples[HEAP_PROFILE_MAX_SAMPLES];
+};
+
+__thread long heapProfileCountdown = 0;
+std::atomic<size_t> heapProfileLiveSamples(0);
+
+static std::atomic<size_t> sampleInterval(0);
+static std::atomic<SampleTable *> table(nullptr);
+
+// guards the samples, the free list and bucket updates
+static std::mutex profileLock;
+static uint32_t freeSamples = NO_SAMPLE;
+// samples below this index have been used
+static uint32_t usedSamples = 0;
+static size_t droppedSamples = 0;
+// the interval of the current profile, kept once sampling stops
+static size_t profileInterval = 0;
+
+// the interval the thread's countdown was drawn for, 0 while idle
+static __thread size_t threadInterval = 0;
+static __thread uint64_t randomState = 0;
+// set while the thread samples, so that nothing the backtrace allocates
+// is sampled
+static __thread bool sampling = false;
+
+static uint32_t get_bucket(void *address) {
+    return uint32_t((uint64_t(address) * 0x9e3779b97f4a7c15uLL) >> 32) % HEAP_PROFILE_MAX_SAMPLES;
+}
+
+// Exponentially distributed bytes until the next sample, so that every
+// allocated byte is equally likely to be sampled whatever the sizes.
+static long next_countdown(size_t interval) {
+    if (randomState == 0) {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        randomState = (uint64_t(&randomState) ^ uint64_t(time.tv_nsec) * 0x9e3779b97f4a7c15uLL) | 1;
+    }
+    // xorshift64*
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    uint64_t random = randomState * 0x2545f4914f6cdd1duLL;
+    double uniform = double((random >> 11) + 1) / double(uint64_t(1) << 53);
+    return long(-std::log(uniform) * double(interval)) + 1;
+}
+
+static void insert_sample(void *address, size_t size, double weight, void **frames, int depth) {
+    std::lock_guard<std::mutex> guard(profileLock);
+    auto samples = table.load(std::memory_order_relaxed);
+    uint32_t index = freeSamples;
+    if (index != NO_SAMPLE) {
+        freeSamples = samples->samples[index].next;
+    } else if (usedSamples < HEAP_PROFILE_MAX_SAMPLES) {
+        index = usedSamples++;
+    } else {
+        droppedSamples++;
+        return;
+    }
+
+    auto &sample = samples->samples[index];
+    sample.address = address;
+    sample.size = size;
+    sample.weight = weight;
+    sample.depth = uint32_t(depth);
+    memcpy(sample.frames, frames, depth * sizeof(void *));
+    auto &bucket = samples->buckets[get_bucket(address)];
+    sample.next = bucket.load(std::memory_order_relaxed);
+    bucket.store(index, std::memory_order_relaxed);
+    heapProfileLiveSamples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void heap_profile_sample(void *address, size_t size) {
+    size_t interval = sampleInterval.load(std::memory_order_relaxed);
+    // an idle countdown or the first one of a thread was not drawn, and
+    // running out of it says nothing about this allocation
+    bool drawn = threadInterval != 0;
+    threadInterval = interval;
+    if (interval == 0) {
+        heapProfileCountdown = HEAP_PROFILE_IDLE_INTERVAL;
+        return;
+    }
+    heapProfileCountdown = next_countdown(interval);
+    if (!drawn || sampling || address == nullptr || size == 0) {
+        return;
+    }
+
+    sampling = true;
+    void *frames[HEAP_PROFILE_MAX_FRAMES + 1];
+    // frame 0 is this function
+    int depth = backtrace(frames, HEAP_PROFILE_MAX_FRAMES + 1) - 1;
+    // the chance that a sample point fell inside `size` bytes
+    double probability = -std::expm1(-double(size) / double(interval));
+    insert_sample(address, size, double(size) / probability, frames + 1, std::max(depth, 0));
+    sampling = false;
+}
+
+void heap_profile_forget(void *address) {
+    auto samples = table.load(std::memory_order_acquire);
+    if (samples == nullptr) {
+        return;
+    }
+    auto &bucket = samples->buckets[get_bucket(address)];
+    if (bucket.load(std::memory_order_relaxed) == NO_SAMPLE) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(profileLock);
+    uint32_t previous = NO_SAMPLE;
+    for (uint32_t index = bucket.load(std::memory_order_relaxed); index != NO_SAMPLE;
+         index = samples->samples[index].next) {
+        auto &sample = samples->samples[index];
+        if (sample.address != address) {
+            previous = index;
+            continue;
+        }
+        if (previous == NO_SAMPLE) {
+            bucket.store(sample.next, std::memory_order_relaxed);
+        } else {
+            samples->samples[previous].next = sample.next;
+        }
+        sample.next = freeSamples;
+        freeSamples = index;
+        heapProfileLiveSamples.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+}
+
+void heap_profile_start(size_t interval) {
+    // backtrace loads its unwinder, allocating, on its first call
+    void *frame;
+    backtrace(&frame, 1);
+
+    std::lock_guard<std::mutex> guard(profileLock);
+    auto samples = table.load(std::memory_order_relaxed);
+    if (samples == nullptr) {
+        void *memory = mmap(nullptr, sizeof(SampleTable), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        samples = (SampleTable *)memory;
+    }
+    for (auto &bucket : samples->buckets) {
+        bucket.store(NO_SAMPLE, std::memory_order_relaxed);
+    }
+    freeSamples = NO_SAMPLE;
+    usedSamples = 0;
+    droppedSamples = 0;
+    profileInterval = interval;
+    heapProfileLiveSamples.store(0, std::memory_order_relaxed);
+    table.store(samples, std::memory_order_release);
+    sampleInterval.store(interval, std::memory_order_relaxed);
+}
+
+void heap_profile_stop() {
+    sampleInterval.store(0, std::memory_order_relaxed);
+}
+
+size_t heap_profile_live_bytes() {
+    std::lock_guard<std::mutex> guard(profileLock);
+    auto samples = table.load(std::memory_order_relaxed);
+    double bytes = 0;
+    for (uint32_t i = 0; samples != nullptr && i < HEAP_PROFILE_MAX_SAMPLES; i++) {
+        for (uint32_t index = samples->buckets[i].load(std::memory_order_relaxed); index != NO_SAMPLE;
+             index = samples->samples[index].next) {
+            bytes += samples->samples[index].weight;
+        }
+    }
+    return size_t(bytes);
+}
+
+//
+// dump
+//
+
+// the live samples of one call stack
+struct StackTotal {
+    double bytes;
+    double allocations;
+    size_t samples;
+    const HeapSample *first;
+};
+
+static bool stack_before(const HeapSample &left, const HeapSample &right) {
+    if (left.depth != right.depth) {
+        return left.depth < right.depth;
+    }
+    return std::lexicographical_compare(left.frames, left.frames + left.depth, right.frames, right.frames + right.depth);
+}
+
+static bool same_stack(const HeapSample &left, const HeapSample &right) {
+    return left.depth == right.depth && std::equal(left.frames, left.frames + left.depth, right.frames);
+}
+
+bool heap_profile_dump(int fd) {
+    // Samples are copied out, so that sorting and writing them happen
+    // outside the lock, into a mapping of their own.
+    size_t count = 0;
+    size_t dropped;
+    size_t interval;
+    HeapSample *copies = nullptr;
+    StackTotal *totals = nullptr;
+    size_t scratchSize = 0;
+    {
+        std::lock_guard<std::mutex> guard(profileLock);
+        auto samples = table.load(std::memory_order_relaxed);
+        size_t live = heapProfileLiveSamples.load(std::memory_order_relaxed);
+        dropped = droppedSamples;
+        interval = profileInterval;
+        if (samples != nullptr && live > 0) {
+            scratchSize = live * (sizeof(HeapSample) + sizeof(StackTotal));
+            void *memory = mmap(nullptr, scratchSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED) {
+                return false;
+            }
+            copies = (HeapSample *)memory;
+            totals = (StackTotal *)(copies + live);
+            for (uint32_t i = 0; i < HEAP_PROFILE_MAX_SAMPLES; i++) {
+                for (uint32_t index = samples->buckets[i].load(std::memory_order_relaxed); index != NO_SAMPLE;
+                     index = samples->samples[index].next) {
+                    copies[count++] = samples->samples[index];
+                }
+            }
+        }
+    }
+
+    std::sort(copies, copies + count, stack_before);
+    size_t stacks = 0;
+    double liveBytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || !same_stack(copies[i - 1], copies[i])) {
+            totals[stacks++] = {0, 0, 0, &copies[i]};
+        }
+        auto &total = totals[stacks - 1];
+        total.bytes += copies[i].weight;
+        total.allocations += copies[i].weight / double(copies[i].size);
+        total.samples++;
+        liveBytes += copies[i].weight;
+    }
+    std::sort(totals, totals + stacks, [](const StackTotal &left, const StackTotal &right) {
+        return left.bytes > right.bytes;
+    });
+
+    bool written = dprintf(fd, "heap profile: %zu live bytes in %zu samples, %zu stacks, %zu dropped, sampling every %zu bytes\n",
+                           size_t(liveBytes), count, stacks, dropped, interval) > 0;
+    for (size_t i = 0; written && i < stacks; i++) {
+        written = dprintf(fd, "\n%zu bytes (%.1f%%) in %zu allocations, %zu samples\n", size_t(totals[i].bytes),
+                          100 * totals[i].bytes / liveBytes, size_t(std::llround(totals[i].allocations)),
+                          totals[i].samples) > 0;
+        backtrace_symbols_fd(totals[i].first->frames, int(totals[i].first->depth), fd);
+    }
+
+    if (copies != nullptr) {
+        munmap(copies, scratchSize);
+    }
+    return written;
+}
@@ -0,0 +1,65 @@
+#ifndef HEAP_PROFILE_PROFILE_H
+#define HEAP_PROFILE_PROFILE_H
+
+
+#include <atomic>
+#include <cstddef>
+
+//
+// Sampling heap profiler. While sampling, roughly one allocation per
+// `interval` allocated bytes is sampled: its backtrace is kept in a table
+// of live samples until the block is freed. Every sample stands for the
+// bytes it is expected to represent, so the table gives an estimate of
+// the live bytes owned by each call stack.
+//
+// Allocators call heap_profile_alloc and heap_profile_free when built
+// with -DHEAP_PROFILE. Sampling is off until heap_profile_start.
+//
+
+#define HEAP_PROFILE_DEFAULT_INTERVAL (512 * 1024)
+// deepest stack a sample keeps
+#define HEAP_PROFILE_MAX_FRAMES 32
+// live samples beyond this are dropped
+#define HEAP_PROFILE_MAX_SAMPLES (1 << 16)
+// bytes a thread allocates between looks at whether sampling has started
+#define HEAP_PROFILE_IDLE_INTERVAL (1 << 20)
+
+// Bytes the calling thread allocates until its next sample. Plain
+// __thread, unlike thread_local, is read without a call from other
+// translation units.
+extern __thread long heapProfileCountdown;
+extern std::atomic<size_t> heapProfileLiveSamples;
+
+// Samples about one allocation per `interval` bytes, starting a new
+// profile. Threads notice within HEAP_PROFILE_IDLE_INTERVAL bytes.
+void heap_profile_start(size_t interval = HEAP_PROFILE_DEFAULT_INTERVAL);
+
+// Stops sampling. Samples still live stay in the profile until freed.
+void heap_profile_stop();
+
+// Writes the live samples grouped by call stack, largest first.
+// Returns false if writing fails.
+bool heap_profile_dump(int fd);
+
+// estimated bytes live in sampled call stacks
+size_t heap_profile_live_bytes();
+
+// slow paths of the hooks
+void heap_profile_sample(void *address, size_t size);
+void heap_profile_forget(void *address);
+
+inline void heap_profile_alloc(void *address, size_t size) {
+    heapProfileCountdown -= long(size);
+    if (heapProfileCountdown < 0) {
+        heap_profile_sample(address, size);
+    }
+}
+
+inline void heap_profile_free(void *address) {
+    if (heapProfileLiveSamples.load(std::memory_order_relaxed) != 0) {
+        heap_profile_forget(address);
+    }
+}
+
+
+#endif //HEAP_PROFILE_PROFILE_H
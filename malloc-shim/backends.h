@@ -0,0 +1,32 @@
+#ifndef MALLOC_SHIM_BACKENDS_H
+#define MALLOC_SHIM_BACKENDS_H
+
+
+#include <cstddef>
+
+// The allocators the shim can route to. The buddy and first-fit projects
+// both declare a global `struct Block`, so each is wrapped in a
+// translation unit of its own behind this function table. Pointers are
+// at least MALLOC_ALIGNMENT aligned; functions are safe from any thread
+// and never see nullptr.
+#define MALLOC_ALIGNMENT 16
+
+struct ShimBackend {
+    const char *name;
+    void *(*allocate)(size_t size);
+    void *(*allocateZeroed)(size_t size);
+    // `alignment` is a power of two above MALLOC_ALIGNMENT
+    void *(*allocateAligned)(size_t alignment, size_t size);
+    void (*deallocate)(void *pointer);
+    void *(*reallocate)(void *pointer, size_t size);
+    size_t (*usableSize)(void *pointer);
+    // held across fork(), or nullptr
+    void (*lock)();
+    void (*unlock)();
+};
+
+extern const ShimBackend firstFitBackend;
+extern const ShimBackend buddyBackend;
+
+
+#endif //MALLOC_SHIM_BACKENDS_H
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sys/mman.h>
+#include "bootstrap.h"
+
+#define CLASSES_COUNT 64
+
+// right below every pointer handed out
+struct BootstrapHeader {
+    // the class block, aligned to its size
+    char *block;
+    size_t sizeClass;
+};
+
+// free blocks are linked through their first word
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+static std::atomic<char *> reserveBegin(nullptr);
+
+// guards the break and the free lists
+static std::mutex bootstrapLock;
+static char *reserveBrk = nullptr;
+static char *reserveEnd = nullptr;
+static FreeBlock *freeBlocks[CLASSES_COUNT] = {};
+
+static size_t ceil_log2(size_t value) {
+    return value <= 1 ? 0 : 64 - __builtin_clzl(value - 1);
+}
+
+static bool reserve() {
+    if (reserveBrk != nullptr) {
+        return true;
+    }
+    void *memory = mmap(nullptr, BOOTSTRAP_RESERVE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    reserveBrk = (char *)memory;
+    reserveEnd = reserveBrk + BOOTSTRAP_RESERVE_SIZE;
+    reserveBegin.store(reserveBrk, std::memory_order_release);
+    return true;
+}
+
+static void push_block(char *block, size_t sizeClass) {
+    auto free = (FreeBlock *)block;
+    free->next = freeBlocks[sizeClass];
+    freeBlocks[sizeClass] = free;
+}
+
+// A new block from the break, which is first aligned to the block size;
+// the space skipped goes to the free lists as smaller aligned blocks.
+static char * take_block(size_t sizeClass) {
+    size_t size = size_t(1) << sizeClass;
+    while (uintptr_t(reserveBrk) % size != 0) {
+        size_t gapClass = __builtin_ctzl(uintptr_t(reserveBrk));
+        if (reserveBrk + (size_t(1) << gapClass) > reserveEnd) {
+            return nullptr;
+        }
+        push_block(reserveBrk, gapClass);
+        reserveBrk += size_t(1) << gapClass;
+    }
+    if (size > size_t(reserveEnd - reserveBrk)) {
+        return nullptr;
+    }
+    char *block = reserveBrk;
+    reserveBrk += size;
+    return block;
+}
+
+void * bootstrap_alloc(size_t size, size_t alignment) {
+    alignment = std::max(alignment, size_t(1) << BOOTSTRAP_MIN_SHIFT);
+    // the header takes the first `alignment` bytes of the block
+    size_t needed = size + alignment;
+    if (needed < size || needed > BOOTSTRAP_RESERVE_SIZE) {
+        return nullptr;
+    }
+    size_t sizeClass = std::max(ceil_log2(needed), size_t(BOOTSTRAP_MIN_SHIFT));
+
+    std::lock_guard<std::mutex> guard(bootstrapLock);
+    if (!reserve()) {
+        return nullptr;
+    }
+    char *block;
+    if (freeBlocks[sizeClass] != nullptr) {
+        block = (char *)freeBlocks[sizeClass];
+        freeBlocks[sizeClass] = freeBlocks[sizeClass]->next;
+    } else if ((block = take_block(sizeClass)) == nullptr) {
+        return nullptr;
+    }
+
+    char *pointer = block + alignment;
+    auto header = (BootstrapHeader *)pointer - 1;
+    header->block = block;
+    header->sizeClass = sizeClass;
+    return pointer;
+}
+
+void bootstrap_free(void *pointer) {
+    auto header = (BootstrapHeader *)pointer - 1;
+    std::lock_guard<std::mutex> guard(bootstrapLock);
+    push_block(header->block, header->sizeClass);
+}
+
+size_t bootstrap_usable_size(void *pointer) {
+    auto header = (BootstrapHeader *)pointer - 1;
+    return size_t(header->block + (size_t(1) << header->sizeClass) - (char *)pointer);
+}
+
+bool bootstrap_owns(void *pointer) {
+    char *begin = reserveBegin.load(std::memory_order_acquire);
+    return begin != nullptr && (char *)pointer >= begin && (char *)pointer < begin + BOOTSTRAP_RESERVE_SIZE;
+}
+
+void bootstrap_lock() {
+    bootstrapLock.lock();
+}
+
+void bootstrap_unlock() {
+    bootstrapLock.unlock();
+}
@@ -0,0 +1,35 @@
+#ifndef MALLOC_SHIM_BOOTSTRAP_H
+#define MALLOC_SHIM_BOOTSTRAP_H
+
+
+#include <cstddef>
+
+//
+// Heap of the shim itself, for everything that cannot go to the chosen
+// allocator: allocations made before the environment can be read, and
+// the allocators' own bookkeeping (buddy chunk maps, first-fit's idle
+// heap list), which would otherwise reenter them under their locks.
+// Power-of-two classes are carved from one reserved mapping and
+// recycled through a free list per class.
+//
+
+// address space reserved up front; only touched pages are backed
+#define BOOTSTRAP_RESERVE_SIZE (size_t(1) << 32)
+// smallest class, which is also the header size and the alignment
+#define BOOTSTRAP_MIN_SHIFT 4
+
+// nullptr once the reservation is exhausted
+void * bootstrap_alloc(size_t size, size_t alignment);
+
+void bootstrap_free(void *pointer);
+
+size_t bootstrap_usable_size(void *pointer);
+
+bool bootstrap_owns(void *pointer);
+
+// held across fork(), so that the child finds the heap consistent
+void bootstrap_lock();
+void bootstrap_unlock();
+
+
+#endif //MALLOC_SHIM_BOOTSTRAP_H
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unistd.h>
+#include "backends.h"
+#include "ChunkedAllocator.h"
+
+// One ChunkedAllocator behind a mutex, so that the heap grows and
+// shrinks by chunks with the program. Blocks are aligned to their size
+// within page-aligned chunks, so alignments up to a page are a matter
+// of block size; larger ones are refused.
+
+// MemoryAllocator takes its size as an int
+#define MAX_REQUEST (size_t(1) << 30)
+
+static std::mutex buddyLock;
+// constructed on first use, and never destroyed: blocks are freed until
+// the very end of the process
+alignas(ChunkedAllocator) static char buddyStorage[sizeof(ChunkedAllocator)];
+static ChunkedAllocator *buddy = nullptr;
+
+static ChunkedAllocator &get_buddy() {
+    if (buddy == nullptr) {
+        buddy = new (buddyStorage) ChunkedAllocator();
+    }
+    return *buddy;
+}
+
+static void *allocate(size_t size) {
+    if (size > MAX_REQUEST) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(buddyLock);
+    return get_buddy().allocate(size);
+}
+
+static void *allocateZeroed(size_t size) {
+    void *pointer = allocate(size);
+    if (pointer != nullptr) {
+        memset(pointer, 0, size);
+    }
+    return pointer;
+}
+
+static void *allocateAligned(size_t alignment, size_t size) {
+    if (alignment > size_t(sysconf(_SC_PAGESIZE))) {
+        return nullptr;
+    }
+    return allocate(std::max(size, alignment));
+}
+
+static void deallocate(void *pointer) {
+    std::lock_guard<std::mutex> guard(buddyLock);
+    get_buddy().deallocate(pointer);
+}
+
+static size_t usableSize(void *pointer) {
+    std::lock_guard<std::mutex> guard(buddyLock);
+    return get_buddy().getBlockSize(pointer);
+}
+
+// A block is kept while its order still fits, otherwise moved.
+static void *reallocate(void *pointer, size_t size) {
+    size_t blockSize = usableSize(pointer);
+    if (size <= blockSize) {
+        return pointer;
+    }
+    void *moved = allocate(size);
+    if (moved != nullptr) {
+        memcpy(moved, pointer, blockSize);
+        deallocate(pointer);
+    }
+    return moved;
+}
+
+static void lock() {
+    buddyLock.lock();
+}
+
+static void unlock() {
+    buddyLock.unlock();
+}
+
+const ShimBackend buddyBackend = {"buddy", allocate, allocateZeroed, allocateAligned, deallocate,
+                                  reallocate, usableSize, lock, unlock};
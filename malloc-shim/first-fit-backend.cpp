@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "backends.h"
+#include "memory-block.h"
+#include "memory-allocation.h"
+
+// The mem_* interface: a heap per thread, large blocks mapped.
+//
+// mem_alloc only aligns data to a word. Data that is not aligned enough
+// is handed out further into the block, and the word right before the
+// pointer then holds the distance back to the data. Block headers always
+// have USED_FLAG set and distances never do, so that word tells the two
+// cases apart. Every request is padded by the words this may take.
+
+static word_t * get_data(void *pointer) {
+    auto word = ((word_t *)pointer)[-1];
+    return word & USED_FLAG ? (word_t *)pointer : (word_t *)((char *)pointer - word);
+}
+
+static size_t get_offset(word_t *data, size_t alignment) {
+    return (alignment - uintptr_t(data) % alignment) % alignment;
+}
+
+static void * place(word_t *data, size_t alignment) {
+    if (data == nullptr) {
+        return nullptr;
+    }
+    size_t offset = get_offset(data, alignment);
+    auto pointer = (char *)data + offset;
+    if (offset != 0) {
+        ((word_t *)pointer)[-1] = word_t(offset);
+    }
+    return pointer;
+}
+
+static bool pad(size_t size, size_t alignment, size_t &padded) {
+    padded = size + alignment - sizeof(word_t);
+    return padded >= size;
+}
+
+static void *allocate(size_t size) {
+    size_t padded;
+    return pad(size, MALLOC_ALIGNMENT, padded) ? place(mem_alloc(padded), MALLOC_ALIGNMENT) : nullptr;
+}
+
+static void *allocateZeroed(size_t size) {
+    size_t padded;
+    return pad(size, MALLOC_ALIGNMENT, padded) ? place(mem_calloc(1, padded), MALLOC_ALIGNMENT) : nullptr;
+}
+
+static void *allocateAligned(size_t alignment, size_t size) {
+    size_t padded;
+    return pad(size, alignment, padded) ? place(mem_alloc(padded), alignment) : nullptr;
+}
+
+static void deallocate(void *pointer) {
+    mem_free(get_data(pointer));
+}
+
+// The block keeps its offset through mem_realloc; when the new block
+// needs another one, the contents are moved.
+static void *reallocate(void *pointer, size_t size) {
+    auto data = get_data(pointer);
+    size_t offset = (char *)pointer - (char *)data;
+    size_t padded = size + std::max(offset, MALLOC_ALIGNMENT - sizeof(word_t));
+    if (padded < size) {
+        return nullptr;
+    }
+    auto moved = mem_realloc(data, padded);
+    if (moved == nullptr) {
+        return nullptr;
+    }
+    size_t newOffset = get_offset(moved, MALLOC_ALIGNMENT);
+    if (newOffset != offset) {
+        memmove((char *)moved + newOffset, (char *)moved + offset, size);
+    }
+    return place(moved, MALLOC_ALIGNMENT);
+}
+
+static size_t usableSize(void *pointer) {
+    auto data = get_data(pointer);
+    return get_size(get_mem_block(data)) - size_t((char *)pointer - (char *)data);
+}
+
+const ShimBackend firstFitBackend = {"first-fit", allocate, allocateZeroed, allocateAligned, deallocate,
+                                     reallocate, usableSize, mem_lock_all, mem_unlock_all};
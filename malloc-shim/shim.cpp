@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "backends.h"
+#include "bootstrap.h"
+
+// Replaces the malloc family of a program with one of the allocators of
+// this repository:
+//
+//   SHIM_ALLOCATOR=first-fit|buddy LD_PRELOAD=.../libmalloc_shim.so program...
+//
+// first-fit is the default. The allocator is chosen on the first request
+// made once the environment is readable, which may come before any
+// static constructor has run; nothing here depends on one. Requests made
+// earlier, and those the allocators make themselves, are served by the
+// bootstrap heap, and its blocks are freed back to it.
+
+#define SHIM_EXPORT extern "C" __attribute__((visibility("default")))
+
+static std::atomic<const ShimBackend *> chosenBackend(nullptr);
+static pthread_once_t chooseOnce = PTHREAD_ONCE_INIT;
+
+// set while the thread runs inside a backend
+static __thread bool inBackend = false;
+
+static void prepare_fork() {
+    auto backend = chosenBackend.load(std::memory_order_acquire);
+    if (backend->lock != nullptr) {
+        backend->lock();
+    }
+    bootstrap_lock();
+}
+
+static void finish_fork() {
+    auto backend = chosenBackend.load(std::memory_order_acquire);
+    bootstrap_unlock();
+    if (backend->unlock != nullptr) {
+        backend->unlock();
+    }
+}
+
+static void choose_backend() {
+    const char *name = getenv("SHIM_ALLOCATOR");
+    const ShimBackend *backend = &firstFitBackend;
+    if (name != nullptr && strcmp(name, buddyBackend.name) == 0) {
+        backend = &buddyBackend;
+    } else if (name != nullptr && strcmp(name, firstFitBackend.name) != 0) {
+        static const char warning[] = "malloc-shim: unknown SHIM_ALLOCATOR, using first-fit\n";
+        ssize_t written = write(STDERR_FILENO, warning, sizeof(warning) - 1);
+        (void)written;
+    }
+
+    // the handlers are only called once a backend is set
+    inBackend = true;
+    pthread_atfork(prepare_fork, finish_fork, finish_fork);
+    inBackend = false;
+    chosenBackend.store(backend, std::memory_order_release);
+}
+
+// nullptr while requests go to the bootstrap heap
+static const ShimBackend * get_backend() {
+    if (inBackend) {
+        return nullptr;
+    }
+    auto backend = chosenBackend.load(std::memory_order_acquire);
+    if (backend == nullptr && environ != nullptr) {
+        pthread_once(&chooseOnce, choose_backend);
+        backend = chosenBackend.load(std::memory_order_acquire);
+    }
+    return backend;
+}
+
+static void * allocate(size_t alignment, size_t size, bool zeroed) {
+    auto backend = get_backend();
+    void *pointer;
+    if (backend == nullptr) {
+        pointer = bootstrap_alloc(size, alignment);
+        if (pointer != nullptr && zeroed) {
+            memset(pointer, 0, size);
+        }
+    } else {
+        inBackend = true;
+        if (alignment > MALLOC_ALIGNMENT) {
+            pointer = backend->allocateAligned(alignment, size);
+        } else if (zeroed) {
+            pointer = backend->allocateZeroed(size);
+        } else {
+            pointer = backend->allocate(size);
+        }
+        inBackend = false;
+    }
+    if (pointer == nullptr) {
+        errno = ENOMEM;
+    }
+    return pointer;
+}
+
+static bool is_power_of_two(size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+SHIM_EXPORT void *malloc(size_t size) noexcept {
+    return allocate(MALLOC_ALIGNMENT, size, false);
+}
+
+SHIM_EXPORT void free(void *pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    if (bootstrap_owns(pointer)) {
+        bootstrap_free(pointer);
+        return;
+    }
+    auto backend = chosenBackend.load(std::memory_order_acquire);
+    if (backend == nullptr) {
+        // not allocated through the shim
+        return;
+    }
+    int error = errno;
+    bool outer = inBackend;
+    inBackend = true;
+    backend->deallocate(pointer);
+    inBackend = outer;
+    errno = error;
+}
+
+SHIM_EXPORT void *calloc(size_t count, size_t size) noexcept {
+    if (size != 0 && count > SIZE_MAX / size) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return allocate(MALLOC_ALIGNMENT, count * size, true);
+}
+
+SHIM_EXPORT void *realloc(void *pointer, size_t size) noexcept {
+    if (pointer == nullptr) {
+        return allocate(MALLOC_ALIGNMENT, size, false);
+    }
+    if (size == 0) {
+        free(pointer);
+        return nullptr;
+    }
+    if (bootstrap_owns(pointer)) {
+        // moves to wherever new blocks come from
+        void *moved = allocate(MALLOC_ALIGNMENT, size, false);
+        if (moved != nullptr) {
+            memcpy(moved, pointer, std::min(size, bootstrap_usable_size(pointer)));
+            bootstrap_free(pointer);
+        }
+        return moved;
+    }
+
+    auto backend = chosenBackend.load(std::memory_order_acquire);
+    bool outer = inBackend;
+    inBackend = true;
+    void *moved = backend->reallocate(pointer, size);
+    inBackend = outer;
+    if (moved == nullptr) {
+        errno = ENOMEM;
+    }
+    return moved;
+}
+
+SHIM_EXPORT int posix_memalign(void **pointer, size_t alignment, size_t size) noexcept {
+    if (!is_power_of_two(alignment) || alignment % sizeof(void *) != 0) {
+        return EINVAL;
+    }
+    int error = errno;
+    *pointer = allocate(alignment, size, false);
+    errno = error;
+    return *pointer != nullptr ? 0 : ENOMEM;
+}
+
+SHIM_EXPORT void *aligned_alloc(size_t alignment, size_t size) noexcept {
+    if (!is_power_of_two(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return allocate(alignment, size, false);
+}
+
+// glibc extensions: served here too, glibc would hand out blocks of its
+// own heap that end up in free() here
+
+SHIM_EXPORT void *memalign(size_t alignment, size_t size) noexcept {
+    // like glibc, rounds the alignment up to a power of two
+    size_t rounded = MALLOC_ALIGNMENT;
+    while (rounded < alignment && rounded != 0) {
+        rounded <<= 1;
+    }
+    if (rounded == 0) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return allocate(rounded, size, false);
+}
+
+SHIM_EXPORT void *valloc(size_t size) noexcept {
+    return allocate(size_t(sysconf(_SC_PAGESIZE)), size, false);
+}
+
+SHIM_EXPORT void *pvalloc(size_t size) noexcept {
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    size_t rounded = (size + page - 1) & ~(page - 1);
+    if (rounded < size) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return allocate(page, std::max(rounded, page), false);
+}
+
+SHIM_EXPORT size_t malloc_usable_size(void *pointer) noexcept {
+    if (pointer == nullptr) {
+        return 0;
+    }
+    if (bootstrap_owns(pointer)) {
+        return bootstrap_usable_size(pointer);
+    }
+    auto backend = chosenBackend.load(std::memory_order_acquire);
+    bool outer = inBackend;
+    inBackend = true;
+    size_t size = backend->usableSize(pointer);
+    inBackend = outer;
+    return size;
+}